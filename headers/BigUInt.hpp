@@ -0,0 +1,62 @@
+//
+// Created on 16/10/2026.
+//
+
+#ifndef CHORDGENERATOR_BIGUINT_HPP
+#define CHORDGENERATOR_BIGUINT_HPP
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * An unsigned integer of arbitrary size, for the number of solutions of a piece. Only the operations needed to count
+ * and index the solutions are provided.
+ */
+class BigUInt {
+private:
+    std::vector<uint32_t> limbs;        /// the digits in base 2^32, least significant first, without leading zeros
+
+    void trim();
+
+public:
+    BigUInt(uint64_t value = 0);
+
+    BigUInt& operator+=(const BigUInt& other);
+
+    /**
+     * Subtracts a number that is not larger than this one
+     * @param other the number to subtract
+     * @return this number
+     */
+    BigUInt& operator-=(const BigUInt& other);
+
+    bool operator<(const BigUInt& other) const;
+
+    bool operator==(const BigUInt& other) const { return limbs == other.limbs; }
+
+    bool is_zero() const { return limbs.empty(); }
+
+    /**
+     * Returns the decimal logarithm of the number, e.g. to compare numbers of solutions that do not fit in a double
+     * @return the logarithm, -infinity for 0
+     */
+    double log10() const;
+
+    /**
+     * Returns the decimal representation of the number
+     * @return the digits of the number
+     */
+    std::string to_string() const;
+
+    /**
+     * Draws a number uniformly between 0 (included) and bound (excluded)
+     * @param bound a positive number
+     * @param rng the random generator
+     * @return the random number
+     */
+    static BigUInt random_below(const BigUInt& bound, std::mt19937_64& rng);
+};
+
+#endif //CHORDGENERATOR_BIGUINT_HPP
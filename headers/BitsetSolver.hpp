@@ -0,0 +1,87 @@
+//
+// Created on 16/10/2026.
+//
+
+#ifndef CHORDGENERATOR_BITSETSOLVER_HPP
+#define CHORDGENERATOR_BITSETSOLVER_HPP
+
+#include "HarmoniserSolver.hpp"
+#include "TonalityRegistry.hpp"
+
+#include <random>
+
+/**
+ * A solver for pieces with a single tonality that works without Gecode. The domain of each chord is a ChordSet over the
+ * legal chords of the tonality (see TonalityTables), so that the rules of tonal_progression are applied with bitwise
+ * operations: choosing a chord restricts the domain of the next one to its successors, and a backward pass done once
+ * removes the chords that cannot lead to the end of the piece. The search backtracks in a flat array of domains, one
+ * per chord, and finds the same solutions as the CP model.
+ */
+class BitsetSolver {
+private:
+    TonalPieceParameters*   parameters;
+    const TonalityTables*   tables;         /// the legal chords and successions of the tonality
+    vector<ChordSet>        support;        /// the chords that have a successor at each position of the piece
+    unsigned long           nodes;          /// the number of chords tried by the last search
+    unsigned long           fails;          /// the number of dead ends of the last search
+    bool                    stopped;        /// whether the last search was stopped by the fail or time limit
+
+    /**
+     * Explores the search tree and passes each solution to the sink
+     * @param sink the function receiving the solutions, it returns false to stop the search
+     * @param maxSolutions the maximal number of solutions, 0 for all of them
+     * @param seed the seed of the random chord selection, 0 to try the chords in the order of the tables
+     * @param failLimit the maximal number of dead ends, 0 for no limit
+     * @param timeLimit the time limit of the search in milliseconds, 0 for none
+     * @return the number of solutions passed to the sink
+     */
+    unsigned long search(const SolutionSink& sink, unsigned long maxSolutions, unsigned int seed,
+                         unsigned long failLimit, unsigned int timeLimit);
+
+public:
+    /**
+     * Computes the chords that can be used at each position of the piece
+     * @param params the parameters of a piece with a single tonality
+     */
+    explicit BitsetSolver(TonalPieceParameters* params);
+
+    /**
+     * Searches for a solution of the piece. With a seed of 0, the chords are tried in the order of the tables, otherwise
+     * they are chosen at random, like the BRANCH_SIZE_RANDOM branching of TonalPiece.
+     * @param solution the solution, set if one is found
+     * @param seed the seed of the random chord selection
+     * @param failLimit the maximal number of dead ends, 0 for no limit
+     * @param timeLimit the time limit of the search in milliseconds, 0 for none
+     * @return true if a solution was found
+     */
+    bool solve(HarmoniserSolution& solution, unsigned int seed = 0, unsigned long failLimit = 0,
+               unsigned int timeLimit = 0);
+
+    /**
+     * Enumerates the solutions of the piece, with the chords tried in the order of the tables
+     * @param sink the function receiving the solutions, it returns false to stop the enumeration
+     * @param maxSolutions the maximal number of solutions, 0 for all of them
+     * @param timeLimit the time limit of the enumeration in milliseconds, 0 for none
+     * @return the number of solutions passed to the sink
+     */
+    unsigned long enumerate(const SolutionSink& sink, unsigned long maxSolutions = 0, unsigned int timeLimit = 0);
+
+    unsigned long get_nodes() const { return nodes; }
+
+    unsigned long get_fails() const { return fails; }
+
+    bool get_stopped() const { return stopped; }
+};
+
+/**
+ * Finds a solution of a piece with the BitsetSolver when it has a single tonality, and with solve_harmoniser otherwise
+ * or when the options ask for something the BitsetSolver cannot do (optimisation, portfolio, LNS or restarts).
+ * @param params the parameters of the piece
+ * @param solution the solution, set if one is found
+ * @param options the search options, the seed and the time and fail limits are used by both solvers
+ * @return true if a solution was found
+ */
+bool solve_harmoniser_fast(TonalPieceParameters* params, HarmoniserSolution& solution,
+                           const HarmoniserOptions& options = HarmoniserOptions());
+
+#endif //CHORDGENERATOR_BITSETSOLVER_HPP
@@ -8,12 +8,20 @@
 #include "../Diatony/c++/headers/diatony/FourVoiceTexture.hpp"
 #include "../Diatony/c++/headers/diatony/SolveDiatony.hpp"
 
+#include <array>
+#include <iterator>
+
 //todo move all this to Tonality classes
 
+/**
+ * The music theory matrices are constexpr arrays defined once for the whole program. Their consistency is checked at
+ * compile time, and the IntArgs versions used to post the constraints are created once in ChordGeneratorUtilities.cpp.
+ */
+
 ///The number of supported chords, which is the size of the tonalTransitions matrix
 constexpr int nSupportedChords = 16;
 ///Defines possible chord successions.
-const IntArgs tonalTransitions = {
+inline constexpr int tonalTransitionsMatrix[] = {
 ///     I,    II,   III,    IV,     V,    VI,   VII,   Vda,  V/II, V/III,  V/IV,   V/V,  V/VI, V/VII,   bII, 6te_a
         1,     1,     1,     1,     1,     1,     1,     0,     1,     1,     1,     1,     1,     1,     1,     1,    /// I
         1,     1,     0,     1,     1,     0,     0,     1,     0,     0,     1,     1,     0,     0,     0,     0,    /// II
@@ -32,11 +40,13 @@ const IntArgs tonalTransitions = {
         0,     0,     0,     0,     1,     0,     0,     1,     0,     0,     0,     0,     0,     0,     0,     0,    ///bII
         0,     0,     0,     0,     1,     0,     0,     1,     0,     0,     0,     0,     0,     0,     0,     0,    ///6te_a
 };
+static_assert(std::size(tonalTransitionsMatrix) == nSupportedChords * nSupportedChords,
+              "tonalTransitions has a wrong number of elements");
 
 ///The number of supported states, which is the size of the degreeStates matrix
 constexpr int nSupportedStates = 5;
 ///Defines which states can be taken by chords based on their degree
-const IntArgs degreeStates = {
+inline constexpr int degreeStatesMatrix[] = {
 ///     fundamental state,    first inversion,   second inversion,    third inversion,      fourth inversion
                         1,                  1,                  0,                  0,                     0,    /// I
                         1,                  1,                  0,                  0,                     0,    /// II
@@ -55,13 +65,15 @@ const IntArgs degreeStates = {
                         1,                  1,                  0,                  0,                     0,    /// bII
                         1,                  0,                  0,                  0,                     0,    /// 6te_a   todo maybe allow for more states later
 };
+static_assert(std::size(degreeStatesMatrix) == nSupportedChords * nSupportedStates,
+              "degreeStates has a wrong number of elements");
 
 ///The number of supported qualities, which is the size of the majorDegreeQualities matrix
 constexpr int nSupportedQualities = 13;
 ///Defines which qualities can be taken by chords based on their degree
 //todo add alternative chords like mIV in major or mV in minor
 //todo add 9th etc
-const IntArgs majorDegreeQualities = {
+inline constexpr int majorDegreeQualitiesMatrix[] = {
 ///     M,  m,  dim,    aug, Augmented Sixth,   7,  M7,     m7,     dim7, half dim,    mM7,   major_ninth_dom, minor_ninth_dom
         1,  0,    0,      0,               0,   0,   1,      0,        0,        0,      0,                 0,              0,    /// I
         0,  1,    0,      0,               0,   0,   0,      1,        0,        0,      0,                 0,              0,    /// II
@@ -80,8 +92,10 @@ const IntArgs majorDegreeQualities = {
         1,  0,    0,      0,               0,   0,   0,      0,        0,        0,      0,                 0,              0,    /// bII
         0,  0,    0,      0,               1,   0,   0,      0,        0,        0,      0,                 0,              0,    /// 6te_a
 };
+static_assert(std::size(majorDegreeQualitiesMatrix) == nSupportedChords * nSupportedQualities,
+              "majorDegreeQualities has a wrong number of elements");
 
-const IntArgs minorDegreeQualities = {
+inline constexpr int minorDegreeQualitiesMatrix[] = {
 ///     M,  m,  dim,    aug, Augmented Sixth,   7,  M7,     m7,     dim7, half dim,    mM7,  major_ninth_dom, minor_ninth_dom
         0,  1,    0,      0,               0,   0,   0,      1,        0,        0,     0,                 0,              0,    /// I
         0,  0,    1,      0,               0,   0,   0,      0,        0,        1,     0,                 0,              0,    /// II
@@ -100,8 +114,10 @@ const IntArgs minorDegreeQualities = {
         1,  0,    0,      0,               0,   0,   0,      0,        0,        0,     0,                 0,              0,    /// bII
         0,  0,    0,      0,               1,   0,   0,      0,        0,        0,     0,                 0,              0,    /// 6te_a
 };
+static_assert(std::size(minorDegreeQualitiesMatrix) == nSupportedChords * nSupportedQualities,
+              "minorDegreeQualities has a wrong number of elements");
 
-const IntArgs bassBasedOnDegreeAndState = {
+inline constexpr int bassBasedOnDegreeAndStateMatrix[] = {
 ///                  root,              third,              fifth,            seventh,                nineth
 ///     fundamental state,    first inversion,   second inversion,    third inversion,      fourth inversion
              FIRST_DEGREE,       THIRD_DEGREE,       FIFTH_DEGREE,     SEVENTH_DEGREE,         SECOND_DEGREE,         /// I
@@ -121,6 +137,204 @@ const IntArgs bassBasedOnDegreeAndState = {
             SECOND_DEGREE,      FOURTH_DEGREE,       SIXTH_DEGREE,       FIRST_DEGREE,          THIRD_DEGREE,         /// bII
              SIXTH_DEGREE,       FIRST_DEGREE,       THIRD_DEGREE,      FOURTH_DEGREE,         SECOND_DEGREE,         /// 6te_a
 };
+static_assert(std::size(bassBasedOnDegreeAndStateMatrix) == nSupportedChords * nSupportedStates,
+              "bassBasedOnDegreeAndState has a wrong number of elements");
+
+///Defines the quality of each chord without its seventh. The qualities after the last column have no simple version
+inline constexpr int simpleQualitiesMatrix[] = {
+///   Major        Minor        Diminished        Augmented    Dominant7
+    MAJOR_CHORD, MINOR_CHORD, DIMINISHED_CHORD, AUGMENTED_CHORD, MAJOR_CHORD,
+///  Major7       Minor7       Diminished7    Half diminished,      MinorMajor,           Augmented sixth
+    MAJOR_CHORD, MINOR_CHORD, DIMINISHED_CHORD,  DIMINISHED_CHORD,     MINOR_CHORD,           AUGMENTED_CHORD
+};
+///The number of qualities that have a simple version
+constexpr int nSimpleQualities = static_cast<int>(std::size(simpleQualitiesMatrix));
+
+/**
+ * The values of the auxiliary arrays of the model for a chord of a solution, from its degree, state and quality. The
+ * lean model does not have the auxiliary arrays, they are computed with these functions (see ChordProgression::values).
+ */
+using ChordValue = int (*)(int degree, int state, int quality);
+
+constexpr int chord_quality_without_seventh(int, int, const int quality) {
+    return quality < nSimpleQualities ? simpleQualitiesMatrix[quality] : MAJOR_CHORD;
+}
+
+constexpr int chord_has_seventh(int, int, const int quality) { return quality >= DOMINANT_SEVENTH_CHORD ? 1 : 0; }
+
+/// same definition as in chromatic_chords
+constexpr int chord_is_chromatic(const int degree, int, const int quality) {
+    return degree >= FIVE_OF_TWO || (degree == FIFTH_DEGREE && quality == DIMINISHED_SEVENTH_CHORD) ? 1 : 0;
+}
+
+constexpr int chord_bass_degree(const int degree, const int state, int) {
+    return bassBasedOnDegreeAndStateMatrix[degree * nSupportedStates + state];
+}
+
+constexpr int chord_root(const int degree, int, int) {
+    return bassBasedOnDegreeAndStateMatrix[degree * nSupportedStates + FUNDAMENTAL_STATE];
+}
+
+constexpr int chord_third(const int degree, int, int) {
+    return bassBasedOnDegreeAndStateMatrix[degree * nSupportedStates + FIRST_INVERSION];
+}
+
+constexpr int chord_fifth(const int degree, int, int) {
+    return bassBasedOnDegreeAndStateMatrix[degree * nSupportedStates + SECOND_INVERSION];
+}
+
+constexpr int chord_seventh(const int degree, int, int) {
+    return bassBasedOnDegreeAndStateMatrix[degree * nSupportedStates + THIRD_INVERSION];
+}
+
+/***********************************************************************************************************************
+ *                                        Compile time checks                                                          *
+ ***********************************************************************************************************************/
+
+/**
+ * Checks that the states allowed for each degree are consistent with its qualities: a chord can only be in third or
+ * fourth inversion if it can have a seventh, and every degree has at least one state and one quality.
+ * @param degreeQualities the quality matrix of a mode
+ * @return true if the matrices are consistent
+ */
+constexpr bool states_match_qualities(const int* degreeQualities) {
+    for (int degree = 0; degree < nSupportedChords; degree++) {
+        bool anyState = false;      bool anyQuality = false;        bool anySeventh = false;
+        for (int state = 0; state < nSupportedStates; state++)
+            anyState = anyState || degreeStatesMatrix[degree * nSupportedStates + state] == 1;
+        for (int quality = 0; quality < nSupportedQualities; quality++) {
+            const bool allowed = degreeQualities[degree * nSupportedQualities + quality] == 1;
+            anyQuality = anyQuality || allowed;
+            anySeventh = anySeventh || (allowed && quality >= DOMINANT_SEVENTH_CHORD);
+        }
+        if (!anyState || !anyQuality)
+            return false;
+        for (int state = THIRD_INVERSION; state < nSupportedStates; state++)
+            if (degreeStatesMatrix[degree * nSupportedStates + state] == 1 && !anySeventh)
+                return false;
+    }
+    return true;
+}
+static_assert(states_match_qualities(majorDegreeQualitiesMatrix), "degreeStates is inconsistent with majorDegreeQualities");
+static_assert(states_match_qualities(minorDegreeQualitiesMatrix), "degreeStates is inconsistent with minorDegreeQualities");
+
+/**
+ * Checks that the bass matrix only contains diatonic degrees, and that the notes of each chord are all different so that
+ * the state of a chord can be deduced from its bass (see statesByBassMatrix)
+ * @return true if the matrix is consistent
+ */
+constexpr bool bass_degrees_are_distinct() {
+    for (int degree = 0; degree < nSupportedChords; degree++) {
+        for (int state = 0; state < nSupportedStates; state++) {
+            const int bass = bassBasedOnDegreeAndStateMatrix[degree * nSupportedStates + state];
+            if (bass < FIRST_DEGREE || bass > SEVENTH_DEGREE)
+                return false;
+            for (int other = 0; other < state; other++)
+                if (bassBasedOnDegreeAndStateMatrix[degree * nSupportedStates + other] == bass)
+                    return false;
+        }
+    }
+    return true;
+}
+static_assert(bass_degrees_are_distinct(), "bassBasedOnDegreeAndState must contain distinct diatonic degrees for each chord");
+
+/***********************************************************************************************************************
+ *                                        Derived tables                                                               *
+ ***********************************************************************************************************************/
+
+///The distance used in transitionDistancesMatrix when a chord cannot be reached from another one
+constexpr int unreachableChord = nSupportedChords;
+
+/**
+ * Computes the minimal number of transitions needed to go from each chord to each other chord in tonalTransitions
+ * (Floyd-Warshall). The distance from a chord to itself is 0, and unreachableChord if there is no path between two chords.
+ * @return the matrix of distances, indexed by from * nSupportedChords + to
+ */
+constexpr std::array<int, nSupportedChords * nSupportedChords> compute_transition_distances() {
+    std::array<int, nSupportedChords * nSupportedChords> distances{};
+    for (int from = 0; from < nSupportedChords; from++)
+        for (int to = 0; to < nSupportedChords; to++)
+            distances[from * nSupportedChords + to] = from == to ? 0 :
+                (tonalTransitionsMatrix[from * nSupportedChords + to] == 1 ? 1 : unreachableChord);
+    for (int via = 0; via < nSupportedChords; via++)
+        for (int from = 0; from < nSupportedChords; from++)
+            for (int to = 0; to < nSupportedChords; to++) {
+                const int distance = distances[from * nSupportedChords + via] + distances[via * nSupportedChords + to];
+                if (distance < distances[from * nSupportedChords + to])
+                    distances[from * nSupportedChords + to] = distance;
+            }
+    return distances;
+}
+///The minimal number of transitions between two chords (transitive closure of tonalTransitions)
+inline constexpr std::array<int, nSupportedChords * nSupportedChords> transitionDistancesMatrix = compute_transition_distances();
+
+/**
+ * Checks that every chord can be reached from the first degree and can lead back to it
+ * @return true if the transition matrix is connected through the first degree
+ */
+constexpr bool every_chord_returns_to_tonic() {
+    for (int chord = 0; chord < nSupportedChords; chord++)
+        if (transitionDistancesMatrix[FIRST_DEGREE * nSupportedChords + chord] == unreachableChord ||
+            transitionDistancesMatrix[chord * nSupportedChords + FIRST_DEGREE] == unreachableChord)
+            return false;
+    return true;
+}
+static_assert(every_chord_returns_to_tonic(), "tonalTransitions contains chords that cannot reach or be reached from I");
+
+/**
+ * Computes the inverse of bassBasedOnDegreeAndState: the state in which a chord has a given degree at the bass.
+ * @return the matrix of states indexed by degree * 7 + bass degree, -1 if the bass degree is not a note of the chord
+ */
+constexpr std::array<int, nSupportedChords * 7> compute_states_by_bass() {
+    std::array<int, nSupportedChords * 7> states{};
+    for (int i = 0; i < nSupportedChords * 7; i++)
+        states[i] = -1;
+    for (int degree = 0; degree < nSupportedChords; degree++)
+        for (int state = 0; state < nSupportedStates; state++)
+            states[degree * 7 + bassBasedOnDegreeAndStateMatrix[degree * nSupportedStates + state]] = state;
+    return states;
+}
+///The state in which each chord has a given degree at the bass, -1 if it is not one of its notes
+inline constexpr std::array<int, nSupportedChords * 7> statesByBassMatrix = compute_states_by_bass();
+
+///The matrices as argument arrays to post the constraints, defined in ChordGeneratorUtilities.cpp
+extern const IntArgs tonalTransitions;
+extern const IntArgs degreeStates;
+extern const IntArgs majorDegreeQualities;
+extern const IntArgs minorDegreeQualities;
+extern const IntArgs bassBasedOnDegreeAndState;
+extern const IntArgs simpleQualities;
+
+/**
+ * Options changing how the rules of tonal harmony are posted in the model, without changing the rules themselves. The
+ * default values give the decomposed model, where each rule is posted separately on each chord.
+ */
+struct ModelOptions {
+    bool tableModel = false;            /// link the variables of each chord with a single extensional constraint (see chord_table)
+    bool transitionAutomaton = false;   /// post the chord successions as a regular constraint (see chord_transitions_automaton)
+    bool voiceLeadingPropagator = false;/// post the rules on successive chords with a dedicated propagator (see voice_leading_rules)
+    bool leanSpace = false;             /// only create the degree, state, quality and root note variables (see link_chords_with_lean_table)
+};
+
+/// The types of soft rules that can be added to a piece (see SoftRule)
+enum SoftRuleType {
+    INVERSION_SOFT_RULE,                /// each chord that is not in fundamental state costs the weight
+    PREFERRED_STATE_SOFT_RULE,          /// each chord of the given degree that is not in the given state costs the weight
+    REPEATED_DEGREE_SOFT_RULE,          /// each chord with the same degree as the previous one costs the weight
+    SEVENTH_CHORD_SOFT_RULE,            /// each seventh chord costs the weight
+    N_SOFT_RULE_TYPES
+};
+
+/**
+ * A weighted soft rule. Instead of forbidding solutions, each violation of the rule adds its weight to the cost of the
+ * piece, which is minimised by the branch and bound search of solve_harmoniser.
+ */
+struct SoftRule {
+    int type;                           /// a SoftRuleType
+    int weight;                         /// the cost of each violation, must be positive
+    int degree = -1;                    /// the degree the rule applies to, for PREFERRED_STATE_SOFT_RULE
+    int state = -1;                     /// the preferred state of the degree, for PREFERRED_STATE_SOFT_RULE
+};
 
 //todo move these functions to the Utility class
 
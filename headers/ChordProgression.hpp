@@ -21,12 +21,16 @@
  * It requires an argument a starting position in the global piece, a duration, a tonality, and the global variable
  * arrays. It can take optional parameters for the minimum and maximum number of chromatic and seventh chords in the
  * piece.
+ *
+ * In lean mode (ModelOptions::leanSpace), the auxiliary variable arrays are not created and their getters return empty
+ * arrays. Their values on a solution are computed from the assigned degrees, states and qualities (see values).
  */
 class ChordProgression {
 private:
     int start;                                   /// the starting position of the progression in the global piece
     int duration;                                /// the number of chords to be generated in this tonality
     Tonality* tonality;                          /// the tonality of the piece
+    bool lean;                                   /// whether the auxiliary variable arrays are left out of the model
 
     /// optional parameters
     int minChromaticChords;                      /// the min number of chromatic chords that are allowed in the progression (V/x, bII, 6te_a)
@@ -52,7 +56,6 @@ private:
     IntVarArray sevenths;                        /// the seventh notes corresponding to the chord degrees
     IntVarArray isChromatic;                     /// whether the chord is chromatic or not
 
-
 public:
     /**
      * Constructor for ChordProgression objects. It initializes the object with the given parameters, links the subset arrays
@@ -70,12 +73,13 @@ public:
      * @param maxPercentChromaticChords the maximum percentage of chromatic chords in the progression
      * @param minPercentSeventhChords the minimum percentage of seventh chords in the progression
      * @param maxPercentSeventhChords the maximum percentage of seventh chords in the progression
+     * @param options how the constraints are posted in the model
      * @return a ChordProgression object
      */
     ChordProgression(Home home, int start, int duration, Tonality *tonality, IntVarArray states, IntVarArray qualities,
                      IntVarArray qualitiesWithoutSeventh, IntVarArray rootNotes, IntVarArray hasSeventh,
                      double minPercentChromaticChords, double maxPercentChromaticChords, double minPercentSeventhChords,
-                     double maxPercentSeventhChords);
+                     double maxPercentSeventhChords, const ModelOptions& options = ModelOptions());
 
     /**
      * Copy constructor
@@ -91,29 +95,41 @@ public:
 
     Tonality *getTonality() const { return tonality; }
 
-    IntVarArray getChords() { return chords; }
+    bool isLean() const { return lean; }
+
+    IntVarArray getChords() const { return chords; }
 
-    IntVarArray getStates() { return states; }
+    IntVarArray getStates() const { return states; }
 
-    IntVarArray getQualities() { return qualities; }
+    IntVarArray getQualities() const { return qualities; }
 
-    IntVarArray getQualitiesWithoutSeventh() { return qualitiesWithoutSeventh; }
+    IntVarArray getRootNotes() const { return rootNotes; }
 
-    IntVarArray getRootNotes() { return rootNotes; }
+    /// In lean mode, the following arrays are empty (see values)
+    IntVarArray getQualitiesWithoutSeventh() const { return qualitiesWithoutSeventh; }
 
-    IntVarArray getRoots() { return roots; }
+    IntVarArray getRoots() const { return roots; }
 
-    IntVarArray getThirds() { return thirds; }
+    IntVarArray getThirds() const { return thirds; }
 
-    IntVarArray getFifths() { return fifths; }
+    IntVarArray getFifths() const { return fifths; }
 
-    IntVarArray getSevenths() { return sevenths; }
+    IntVarArray getSevenths() const { return sevenths; }
 
-    IntVarArray getBassDegrees() { return bassDegrees; }
+    IntVarArray getBassDegrees() const { return bassDegrees; }
 
-    IntVarArray getIsChromatic() { return isChromatic; }
+    IntVarArray getIsChromatic() const { return isChromatic; }
 
-    IntVarArray getHasSeventh() { return hasSeventh; }
+    IntVarArray getHasSeventh() const { return hasSeventh; }
+
+    /**
+     * Computes the values of an auxiliary array on a solution, from the assigned degree, state and quality of each chord.
+     * It works in both modes, and is the only way to get these values in lean mode.
+     * @param value the value of a chord (e.g. chord_bass_degree, see ChordValue)
+     * @return the value of each chord of the progression
+     * @throws std::runtime_error if a chord is not assigned
+     */
+    vector<int> values(ChordValue value) const;
 
     /**
      * Returns a string with each of the object's field values as integers. For debugging
@@ -54,7 +54,7 @@ void link_states_to_qualities(const Home &home, int size, IntVarArray states, In
  * @param rootNotes the slice of the rootNote array corresponding to this tonality
  * @param chords the array of chord degrees
  */
-void link_root_notes_to_degrees(const Home &home, int size, Tonality *tonality, IntVarArray rootNotes, IntVarArray chords);
+void link_root_notes_to_degrees(const Home &home, int size, const Tonality *tonality, IntVarArray rootNotes, IntVarArray chords);
 
 /**
  * Links the bass degree to the corresponding chord degree and state.
@@ -122,6 +122,130 @@ void seventh_chords(const Home &home, int size, IntVarArray qualities, IntVarArr
  */
 void link_qualities_to_3note_version(const Home &home, int size, IntVarArray qualities, IntVarArray qualityWithoutSeventh);
 
+/***********************************************************************************************************************
+ *                                        Table model                                                                  *
+ ***********************************************************************************************************************/
+
+/// The columns of the tuples in the chord table
+enum ChordTableColumn {
+    TABLE_DEGREE, TABLE_STATE, TABLE_QUALITY, TABLE_BASS, TABLE_ROOT, TABLE_THIRD, TABLE_FIFTH, TABLE_SEVENTH,
+    TABLE_ROOT_NOTE, TABLE_IS_CHROMATIC, TABLE_HAS_SEVENTH,
+    CHORD_TABLE_ARITY
+};
+
+/**
+ * Returns the table of every legal combination of the variables describing a single chord in the given tonality, as
+ * tuples (degree, state, quality, bass, root, third, fifth, seventh, rootNote, isChromatic, hasSeventh). A tuple is
+ * legal if it respects all the linker functions above as well as the rules involving only one chord (flat_II_cst,
+ * chord_states_and_qualities, five_of_seven and diminished_seventh_dominant_chords).
+ * The table is precomputed by the TonalityRegistry and shared by all the progressions in the tonality.
+ * @param tonality the tonality of the progression
+ * @return the table of legal tuples for a chord in this tonality
+ */
+const TupleSet& chord_table(const Tonality *tonality);
+
+/// The columns of the tuples in the lean chord table
+enum LeanChordTableColumn {
+    LEAN_TABLE_DEGREE, LEAN_TABLE_STATE, LEAN_TABLE_QUALITY, LEAN_TABLE_ROOT_NOTE,
+    LEAN_CHORD_TABLE_ARITY
+};
+
+/**
+ * Returns the chord table of the tonality projected on the degree, state, quality and root note of the chord, for the
+ * lean model that has no auxiliary variables.
+ * @param tonality the tonality of the progression
+ * @return the table of legal tuples (degree, state, quality, rootNote) for a chord in this tonality
+ */
+const TupleSet& lean_chord_table(const Tonality *tonality);
+
+/**
+ * Whether a chord respects all the linker functions and the rules involving only one chord (flat_II_cst,
+ * chord_states_and_qualities, five_of_seven and diminished_seventh_dominant_chords).
+ * @param tonality the tonality of the chord
+ * @param degree the degree of the chord
+ * @param state the state of the chord
+ * @param quality the quality of the chord
+ * @return true if the chord is legal in the tonality
+ */
+bool is_legal_chord(const Tonality *tonality, int degree, int state, int quality);
+
+/**
+ * Whether two successive legal chords respect the rules of tonal_progression involving two chords (chord_transitions,
+ * fifth_degree_appogiatura, the first rule of successive_chords_with_same_degree and the rules of voice_leading_rules).
+ * The repetition of a degree more than twice involves three chords and is not checked.
+ * @param degree the degree of the first chord
+ * @param state the state of the first chord
+ * @param quality the quality of the first chord
+ * @param nextDegree the degree of the second chord
+ * @param nextState the state of the second chord
+ * @param nextQuality the quality of the second chord
+ * @return true if the second chord can follow the first one
+ */
+bool is_legal_succession(int degree, int state, int quality, int nextDegree, int nextState, int nextQuality);
+
+/**
+ * Computes the chord table for a tonality. Each combination of degree, state and quality is checked against the rules
+ * involving a single chord (see is_legal_chord), and the values of the auxiliary variables are deduced from the music
+ * theory matrices.
+ * This is called once per tonality by the TonalityRegistry, use chord_table to get the shared table.
+ * @param tonality the tonality of the progression
+ * @param lean if true, the tuples only contain the columns of LeanChordTableColumn
+ * @return the finalized table of legal tuples for a chord in this tonality
+ */
+TupleSet build_chord_table(Tonality *tonality, bool lean = false);
+
+/**
+ * Links all the variables describing each chord with a single extensional constraint on the chord table of the tonality.
+ * This replaces the linker functions and the rules that involve only one chord, without the auxiliary variables that
+ * their decomposition creates. The number of chromatic and seventh chords is constrained as in chromatic_chords and
+ * seventh_chords.
+ * formula: (chords[i], states[i], qualities[i], ..., hasSeventh[i]) in chord_table(tonality)
+ * @param home the problem space
+ * @param size the number of chords in the progression
+ * @param tonality the tonality of the progression
+ * @param chords the array of chord degrees
+ * @param states the array of chord states
+ * @param qualities the array of chord qualities
+ * @param bassDegrees the array of bass degrees
+ * @param roots the array of root notes
+ * @param thirds the array of third notes
+ * @param fifths the array of fifth notes
+ * @param sevenths the array of seventh notes
+ * @param rootNotes the slice of the rootNote array corresponding to this tonality
+ * @param isChromatic the array of chromatic chords
+ * @param hasSeventh the array of seventh chords
+ * @param minChromaticChords the min number of chromatic chords we want
+ * @param maxChromaticChords the max number of chromatic chords we want
+ * @param minSeventhChords the min number of seventh chords we want
+ * @param maxSeventhChords the max number of seventh chords we want
+ */
+void link_chords_with_table(const Home &home, int size, Tonality *tonality, IntVarArray chords, IntVarArray states,
+                            IntVarArray qualities, IntVarArray bassDegrees, IntVarArray roots, IntVarArray thirds,
+                            IntVarArray fifths, IntVarArray sevenths, IntVarArray rootNotes, IntVarArray isChromatic,
+                            IntVarArray hasSeventh, int minChromaticChords, int maxChromaticChords,
+                            int minSeventhChords, int maxSeventhChords);
+
+/**
+ * Links the degree, state, quality and root note of each chord with an extensional constraint on the lean chord table.
+ * The auxiliary variables are not created: the number of chromatic and seventh chords is only counted with temporary
+ * Boolean variables when the bounds can actually remove solutions.
+ * formula: (chords[i], states[i], qualities[i], rootNotes[i]) in lean_chord_table(tonality)
+ * @param home the problem space
+ * @param size the number of chords in the progression
+ * @param tonality the tonality of the progression
+ * @param chords the array of chord degrees
+ * @param states the array of chord states
+ * @param qualities the array of chord qualities
+ * @param rootNotes the slice of the rootNote array corresponding to this tonality
+ * @param minChromaticChords the min number of chromatic chords we want
+ * @param maxChromaticChords the max number of chromatic chords we want
+ * @param minSeventhChords the min number of seventh chords we want
+ * @param maxSeventhChords the max number of seventh chords we want
+ */
+void link_chords_with_lean_table(Home home, int size, Tonality *tonality, IntVarArray chords, IntVarArray states,
+                                 IntVarArray qualities, IntVarArray rootNotes, int minChromaticChords,
+                                 int maxChromaticChords, int minSeventhChords, int maxSeventhChords);
+
 /***********************************************************************************************************************
  *                                                   Constraints                                                       *
  ***********************************************************************************************************************/
@@ -136,6 +260,35 @@ void link_qualities_to_3note_version(const Home &home, int size, IntVarArray qua
  */
 void chord_transitions(const Home &home, int size, IntVarArray chords);
 
+/**
+ * Returns the automaton recognising the valid sequences of chord degrees in the given mode. It accepts the words where
+ * each transition is possible (tonalTransitions), where the same degree does not happen more than twice successively,
+ * and where V/VII is only used in minor mode. The fifth degree appogiatura can only be followed by V in tonalTransitions,
+ * so the part of fifth_degree_appogiatura on the degrees is also covered. The automaton is precomputed by the
+ * TonalityRegistry.
+ * @param tonality the tonality of the progression
+ * @return the automaton for the mode of the tonality
+ */
+const DFA& chord_transitions_automaton(const Tonality *tonality);
+
+/**
+ * Builds the automaton recognising the valid sequences of chord degrees in a mode.
+ * This is called by the TonalityRegistry, use chord_transitions_automaton to get the shared automaton.
+ * @param mode the mode of the tonality
+ * @return the automaton for this mode
+ */
+DFA build_chord_transitions_automaton(int mode);
+
+/**
+ * Enforces that the chord progression is valid with a single regular constraint on the whole chords array, using the
+ * automaton from chord_transitions_automaton. It replaces chord_transitions, five_of_seven and the repetition rule of
+ * successive_chords_with_same_degree, and propagates along the whole sequence instead of pairwise.
+ * @param home the problem space
+ * @param chords the array of chord degrees
+ * @param tonality the tonality of the progression
+ */
+void regular_chord_transitions(const Home &home, const IntVarArray &chords, const Tonality *tonality);
+
 /**
  * Force the last chord to be diatonic and not the seventh chord,
  * The chord progression cannot end on something other than a diatonic chord (also not seventh degree)
@@ -177,9 +330,10 @@ void flat_II_cst(const Home &home, int size, IntVarArray states, IntVarArray cho
  * @param states the array of chord states
  * @param qualities the array of chord qualities
  * @param chords the array of chord degrees
+ * @param degreeRepetitions whether to post the second rule (it is already in the automaton of regular_chord_transitions)
  */
 void successive_chords_with_same_degree(const Home &home, int size, IntVarArray states, IntVarArray qualities,
-                                        IntVarArray chords);
+                                        IntVarArray chords, bool degreeRepetitions = true);
 
 /**
  * Makes sure the state of the chords allows for tritone resolutions in the cases where it is necessary
@@ -242,6 +396,31 @@ void five_of_seven(const Home& home, int size, IntVarArray chords, const Tonalit
  */
 void diminished_seventh_dominant_chords(const Home &home, int size, IntVarArray qualities, IntVarArray chords, IntVarArray states);
 
+/**
+ * Posts a single propagator enforcing the rules of tritone_resolutions, seventh_chords_preparation and
+ * diminished_seventh_dominant_chords on the whole progression. The bass and the notes of the chords are read from
+ * bassBasedOnDegreeAndState instead of the auxiliary variable arrays, and only the windows around the chords whose
+ * variables changed are checked again. See src/VoiceLeadingPropagator.cpp.
+ * @param home the problem space
+ * @param chords the array of chord degrees
+ * @param states the array of chord states
+ * @param qualities the array of chord qualities
+ */
+void voice_leading_rules(Home home, const IntVarArray &chords, const IntVarArray &states, const IntVarArray &qualities);
+
+/**
+ * Whether two successive chords respect the rules enforced by voice_leading_rules (tritone resolutions and preparation
+ * of the seventh). See src/VoiceLeadingPropagator.cpp.
+ * @param degree the degree of the first chord
+ * @param state the state of the first chord
+ * @param quality the quality of the first chord
+ * @param nextDegree the degree of the second chord
+ * @param nextState the state of the second chord
+ * @param nextQuality the quality of the second chord
+ * @return true if the succession is legal
+ */
+bool is_legal_voice_leading(int degree, int state, int quality, int nextDegree, int nextState, int nextQuality);
+
 /***********************************************************************************************************************
  *                                            Optional Constraints (preferences)                                       *
  ***********************************************************************************************************************/
@@ -253,8 +432,8 @@ void diminished_seventh_dominant_chords(const Home &home, int size, IntVarArray
  * @param type the type of cadence
  * @param states the array of chord states
  * @param chords the array of chord degrees
- * @param hasSeventh the array of seventh chords
+ * @param qualities the array of chord qualities
  */
-void cadence(const Home &home, int position, int type, IntVarArray states, IntVarArray chords, IntVarArray hasSeventh);
+void cadence(const Home &home, int position, int type, IntVarArray states, IntVarArray chords, IntVarArray qualities);
 
 #endif //CHORDGENERATOR_CONSTRAINTS_HPP
\ No newline at end of file
@@ -0,0 +1,63 @@
+//
+// Created on 16/10/2026.
+//
+
+#ifndef CHORDGENERATOR_DECOMPOSEDSOLVER_HPP
+#define CHORDGENERATOR_DECOMPOSEDSOLVER_HPP
+
+#include "HarmoniserSolver.hpp"
+
+#include <memory>
+
+/**
+ * A part of a piece that can be solved on its own: consecutive progressions that share chords (i.e. that are linked by
+ * pivot chord modulations), and the modulations between them.
+ */
+struct PieceCluster {
+    int firstProgression;       /// the index of the first progression of the cluster in the piece
+    int lastProgression;        /// the index of the last progression of the cluster in the piece
+    int start;                  /// the position of the first chord of the cluster in the piece
+    int end;                    /// the position of the last chord of the cluster in the piece
+};
+
+/**
+ * Splits a piece into clusters at the modulations whose tonalities do not share any chord. The clusters only interact
+ * through the constraints of these modulations, which apply to the chords around the cut.
+ * @param params the parameters of the piece
+ * @return the clusters, in the order of the piece
+ */
+vector<PieceCluster> find_clusters(const TonalPieceParameters& params);
+
+/**
+ * Creates the parameters of a cluster as a piece of its own, starting at position 0. The model options and the soft
+ * rules of the piece are copied.
+ * @param params the parameters of the piece
+ * @param cluster a cluster of the piece
+ * @return the parameters of the cluster
+ */
+std::unique_ptr<TonalPieceParameters> cluster_parameters(const TonalPieceParameters& params, const PieceCluster& cluster);
+
+/**
+ * Solves a piece by parts. The piece is split into clusters (see find_clusters), which are solved in parallel with
+ * solve_harmoniser_batch. The solutions of the clusters are then joined with a search on the whole piece in which only
+ * the chords around the cuts are free, so that the constraints of the modulations at the cuts can be satisfied. If the
+ * join fails, the windows around the cuts are doubled until they cover the whole piece. The solution is the same as
+ * solve_harmoniser would give when the piece has a single cluster.
+ * The time limit of the options is shared by all the phases: the clusters and each join get the time left until the
+ * end of the limit. The report tells whether the search was stopped by the limits, in which case nullptr does not mean
+ * that the piece has no solution. Its statistics add up the ones of the joins.
+ * @param params the parameters of the piece, they must outlive the solution
+ * @param report the report of the search, filled by the function
+ * @param workers the number of worker threads for the clusters, 0 for one per core
+ * @param window the number of chords freed on each side of a cut for the first join
+ * @param options the search options, the portfolio and optimisation modes are not supported
+ * @return the solution, or nullptr if no solution was found
+ */
+TonalPiece* solve_harmoniser_decomposed(TonalPieceParameters* params, SearchReport& report, unsigned int workers = 0,
+                                        int window = 2, const HarmoniserOptions& options = HarmoniserOptions());
+
+/// see solve_harmoniser_decomposed(TonalPieceParameters*, SearchReport&, unsigned int, int, const HarmoniserOptions&)
+TonalPiece* solve_harmoniser_decomposed(TonalPieceParameters* params, unsigned int workers = 0, int window = 2,
+                                        const HarmoniserOptions& options = HarmoniserOptions());
+
+#endif //CHORDGENERATOR_DECOMPOSEDSOLVER_HPP
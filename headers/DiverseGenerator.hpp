@@ -0,0 +1,38 @@
+//
+// Created on 16/10/2026.
+//
+
+#ifndef CHORDGENERATOR_DIVERSEGENERATOR_HPP
+#define CHORDGENERATOR_DIVERSEGENERATOR_HPP
+
+#include "HarmoniserSolver.hpp"
+
+/**
+ * Returns a hash of the degrees, states and qualities of a solution, the values that make two harmonisations different
+ * @param solution a solution
+ * @return the hash of the solution
+ */
+size_t solution_hash(const HarmoniserSolution& solution);
+
+/**
+ * Generates distinct solutions of a piece with independent searches in parallel. Search k uses the seed options.seed + k
+ * for its random value selection, and its solution is kept if no kept solution has the same degrees, states and
+ * qualities (solution_hash is only used to find the kept solutions to compare with). The model of the piece is built
+ * and propagated once, every search starts from a clone of it (see TemplatePool). The generation stops once count
+ * distinct solutions are found, maxSearches searches are done or the time budget is spent: no search starts after the
+ * end of the budget, and each search gets at most the time left.
+ * @param params the parameters of the piece
+ * @param count the number of distinct solutions wanted
+ * @param workers the number of worker threads, 0 for one per core
+ * @param maxSearches the maximal number of searches, 0 for 4 * count
+ * @param budget the time limit of the whole generation in milliseconds, 0 for none
+ * @param options the search options of every search, the time and fail limits apply to each of them. The portfolio mode
+ * is not supported.
+ * @return the distinct solutions, in the order they were found
+ */
+vector<HarmoniserSolution> solve_harmoniser_diverse(TonalPieceParameters* params, unsigned int count,
+                                                    unsigned int workers = 0, unsigned long maxSearches = 0,
+                                                    unsigned int budget = 0,
+                                                    const HarmoniserOptions& options = HarmoniserOptions());
+
+#endif //CHORDGENERATOR_DIVERSEGENERATOR_HPP
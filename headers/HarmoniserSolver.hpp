@@ -7,12 +7,186 @@
 
 #include "TonalPiece.hpp"
 
+#include <chrono>
+#include <functional>
+#include <ostream>
+
+/// The cutoff sequences for the restarts (see HarmoniserOptions)
+enum RestartCutoff {
+    LUBY_CUTOFF,                /// Luby sequence multiplied by the scale
+    GEOMETRIC_CUTOFF,           /// scale * base^i
+    MERGED_CUTOFF               /// linear sequence of 2 * scale merged with a geometric sequence starting at 4 * scale
+};
+
+/**
+ * Options for the search of solve_harmoniser. The default values give a single threaded depth first search with the
+ * branching posted by the TonalPiece constructor.
+ */
+struct HarmoniserOptions {
+    bool portfolio = false;         /// run several engines with different heuristics and restarts concurrently
+    unsigned int assets = 0;        /// the number of engines in the portfolio, 0 for one per core
+    unsigned int seed = 1;          /// the seed of the random value selection, for pieces without branching
+
+    bool restarts = false;          /// restart the search when the number of failures reaches the cutoff
+    int cutoff = LUBY_CUTOFF;       /// the RestartCutoff sequence for the restarts (also used by the portfolio)
+    unsigned long cutoffScale = 0;  /// the scale of the cutoff sequence, 0 for the number of chords in the piece
+    double geometricBase = 1.5;     /// the base of the geometric sequences
+    unsigned int nogoodsLimit = 128;/// the maximal depth of the nogoods extracted at each restart, 0 to disable them
+
+    bool optimise = false;          /// minimise the cost of the soft rules with a branch and bound search
+    std::function<void(const TonalPiece&)> onImprovement;   /// called with each improving solution in optimisation and LNS modes
+
+    bool lns = false;               /// large neighbourhood search around the best solution, needs a time or fail limit
+    int lnsWindow = 8;              /// the maximal number of chords relaxed at each restart of the LNS
+    unsigned long lnsFailLimit = 200;   /// the number of failures after which the LNS moves to another window
+
+    unsigned int timeLimit = 0;     /// the time limit of the search in milliseconds, 0 for none
+    unsigned long failLimit = 0;    /// the maximal number of failures of the search, 0 for none
+
+    bool autoRecomputation = false; /// choose the copy and recomputation distances from the size of the piece
+    unsigned int commitDistance = 0;/// the number of nodes between two copies of the space, 0 for the default
+    unsigned int adaptiveDistance = 0;  /// the distance of the adaptive recomputation, 0 for the default
+};
+
+/// The outcome of a search (see solve_harmoniser)
+struct SearchReport {
+    Search::Statistics statistics;  /// the statistics of the engine
+    bool stopped = false;           /// whether the search was stopped by the time or fail limit
+    double time = 0;                /// the duration of the search in seconds
+    unsigned long solutions = 0;    /// the number of solutions found
+    unsigned long clones = 0;       /// the number of clones of the piece made by the engines of this search
+    /// the peak resident memory of the whole process at the end of the search, in bytes. It is not the memory of this
+    /// search: it never decreases and includes the other searches and threads of the process.
+    size_t processPeakRss = 0;
+};
+
 /**
  * Solves a harmonization problem for a given TonalPiece.
+ * With restarts, the search restarts from the root each time the number of failures reaches the next value of the
+ * cutoff sequence, and the nogoods learnt from the previous restart are posted. Since the values of the chords are chosen
+ * at random, each restart explores a different part of the search tree.
+ * In optimisation mode, a branch and bound search minimises the cost of the soft rules of the piece (see SoftRule), and
+ * the best solution is returned once the search is complete.
+ * In large neighbourhood mode, the search restarts each time the fail limit is reached or a solution is found. After
+ * the first solution, only a window of the piece is relaxed around the incumbent at each restart, and a cheaper
+ * solution is looked for in this window until the time or fail limit is reached (see TonalPiece::relax). Without soft rules,
+ * the first solution is returned.
+ * In portfolio mode, the piece must be created without branching: each engine of the portfolio posts its own
+ * BranchingStrategy with its own seed, and half of them restart with the cutoff sequence. The first solution found by
+ * any engine is returned and the other engines are stopped.
+ * In the other modes, a piece created without branching gets the default branching with the seed of the options.
  * @param piece the TonalPiece to solve
  * @param print if true, prints the number of solutions and the last solution found
+ * @param options the search options
+ * @param report the report of the search, filled by the function
  * @return the last solution found, or nullptr if no solution was found
  */
-TonalPiece* solve_harmoniser(TonalPiece* piece, bool print = false);
+TonalPiece* solve_harmoniser(TonalPiece* piece, SearchReport& report, bool print = false,
+                             const HarmoniserOptions& options = HarmoniserOptions());
+
+/// see solve_harmoniser(TonalPiece*, SearchReport&, bool, const HarmoniserOptions&)
+TonalPiece* solve_harmoniser(TonalPiece* piece, bool print = false, const HarmoniserOptions& options = HarmoniserOptions());
+
+/**
+ * A solution of the harmonisation problem as plain integers, so that it can be kept or passed on once the TonalPiece it
+ * was extracted from is deleted.
+ */
+struct HarmoniserSolution {
+    vector<vector<int>> degrees;    /// the chord degrees of each progression, relative to its tonality
+    vector<int> states;             /// the state of each chord of the piece
+    vector<int> qualities;          /// the quality of each chord of the piece
+    vector<int> rootNotes;          /// the root note of each chord of the piece
+    int cost = 0;                   /// the cost of the soft rules of the piece
+
+    HarmoniserSolution() = default;
+
+    /**
+     * Extracts the values of a solved piece
+     * @param piece a TonalPiece whose variables are all assigned
+     */
+    explicit HarmoniserSolution(const TonalPiece& piece);
+
+    /**
+     * Computes the cost of the soft rules of a piece for this solution, as post_soft_rules does in the model. It is
+     * used by the solvers that do not create a TonalPiece.
+     * @param params the parameters of the piece the solution belongs to
+     * @return the weighted number of violations of the soft rules
+     */
+    int soft_rules_cost(const TonalPieceParameters& params) const;
+
+    /**
+     * Returns the solution on a single line: the cost, then the degrees of each progression separated by commas, the
+     * states, the qualities and the root notes, separated by semicolons.
+     * @return a string representation of the solution
+     */
+    string toString() const;
+};
+
+/// Receives the solutions of enumerate_harmoniser, returns false to stop the enumeration
+using SolutionSink = std::function<bool(const HarmoniserSolution&)>;
+
+/**
+ * Returns a sink that writes each solution on a line of the given stream (see HarmoniserSolution::toString). The stream
+ * must outlive the enumeration.
+ * @param os the output stream, e.g. std::cout or a std::ofstream
+ * @return the sink
+ */
+SolutionSink ostream_sink(std::ostream& os);
+
+/**
+ * Enumerates the solutions of a TonalPiece. Each solution is converted to a HarmoniserSolution and passed to the sink,
+ * and its space is deleted right away, so that the memory used does not depend on the number of solutions. In
+ * optimisation mode, only the improving solutions are enumerated. The restart, LNS and portfolio modes are not
+ * supported, as they can return the same solution several times. A piece created without branching gets the default
+ * branching with the seed of the options.
+ * @param piece the TonalPiece to solve, it is deleted by the function
+ * @param sink the function receiving the solutions
+ * @param maxSolutions the maximal number of solutions, 0 for all of them
+ * @param options the search options
+ * @return the number of solutions passed to the sink
+ */
+unsigned long enumerate_harmoniser(TonalPiece* piece, const SolutionSink& sink, unsigned long maxSolutions = 0,
+                                   const HarmoniserOptions& options = HarmoniserOptions());
+
+/// The result of a job of solve_harmoniser_batch
+struct BatchResult {
+    bool solved = false;            /// whether a solution was found
+    HarmoniserSolution solution;    /// the solution, if one was found
+    SearchReport report;            /// the statistics of the search
+    string error;                   /// the message of the exception thrown by the job, empty if there was none
+};
+
+/**
+ * Solves a batch of independent pieces on a pool of worker threads. Each worker takes the next job that has not been
+ * started, creates its TonalPiece and solves it with solve_harmoniser, so that long and short pieces are balanced
+ * between the workers. The seed and the time and fail limits of the options apply to each job separately.
+ * @param jobs the parameters of each piece, they must outlive the function
+ * @param workers the number of worker threads, 0 for one per core
+ * @param options the search options of every job, the portfolio mode is not supported
+ * @return the result of each job, in the order of the jobs
+ */
+vector<BatchResult> solve_harmoniser_batch(const vector<TonalPieceParameters*>& jobs, unsigned int workers = 0,
+                                           const HarmoniserOptions& options = HarmoniserOptions());
+
+/**
+ * Solves a batch of independent pieces before a deadline shared by all the jobs. Each job gets the time left until the
+ * deadline as its time limit, and the jobs that are not started before the deadline are reported as stopped without
+ * being searched. The other options apply to each job as in solve_harmoniser_batch.
+ * @param jobs the parameters of each piece, they must outlive the function
+ * @param workers the number of worker threads, 0 for one per core
+ * @param options the search options of every job, the portfolio mode is not supported
+ * @param deadline the time at which the batch must be finished
+ * @return the result of each job, in the order of the jobs
+ */
+vector<BatchResult> solve_harmoniser_batch(const vector<TonalPieceParameters*>& jobs, unsigned int workers,
+                                           const HarmoniserOptions& options,
+                                           std::chrono::steady_clock::time_point deadline);
+
+/**
+ * Returns the time left until a deadline, to be used as the time limit of a search
+ * @param deadline the deadline
+ * @return the time left in milliseconds, at least 1 if the deadline has not passed, 0 if it has
+ */
+unsigned int time_left(std::chrono::steady_clock::time_point deadline);
 
 #endif //HARMONISERSOLVER_HPP
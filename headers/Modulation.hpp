@@ -11,13 +11,14 @@
 /**
  * This class represents a modulation between two progressions in two tonalities. It takes as argument a search space, a type of modulation,
  * a start position, and end position as well as two chord progressions to modulate between.
- * It posts constraints based on the type of modulation on the variables from the chord progressions.
+ * It posts constraints based on the type of modulation on the variables from the chord progressions. It does not keep
+ * references to the progressions, so it can be copied with the piece without copying them.
  */
 class Modulation {
 private:
     int type;       int start;      int end;
 
-    ChordProgression* from;    ChordProgression* to;
+    Tonality* fromTonality;    Tonality* toTonality;
 
 public:
     /**
@@ -30,44 +31,55 @@ public:
      * @param from the chord progression to modulate from
      * @param to the chord progression to modulate to
      */
-    Modulation(const Home& home, int type, int start, int end, ChordProgression *from, ChordProgression *to);
+    Modulation(const Home& home, int type, int start, int end, ChordProgression &from, ChordProgression &to);
 
-    /**
-     * Copy constructor
-     * @param home the search space
-     * @param m a Modulation object
-     */
-    Modulation(const Home &home, const Modulation& m);
+    int getType() const { return type; }
+
+    int getStart() const { return start; }
+
+    int getEnd() const { return end; }
+
+    Tonality *getFromTonality() const { return fromTonality; }
+
+    Tonality *getToTonality() const { return toTonality; }
 
     /**
      * This function posts the constraints for a perfect cadence modulation. It ensures that the first chord progression
      * ends in a perfect cadence.
      * @param home the search space
+     * @param from the chord progression to modulate from
+     * @param to the chord progression to modulate to
      */
-    void perfect_cadence_modulation(const Home &home) const;
+    void perfect_cadence_modulation(const Home &home, ChordProgression &from, ChordProgression &to) const;
 
     /**
      * This function posts the constraints for a pivot chord modulation. It ensures that from the start of the modulation
      * to the end minus two chords, all chords are in both tonalities. The last two chords of the modulation are a perfect
      * cadence in the new tonality
      * @param home the search space
+     * @param from the chord progression to modulate from
+     * @param to the chord progression to modulate to
      */
-    void pivot_chord_modulation(const Home &home) const;
+    void pivot_chord_modulation(const Home &home, ChordProgression &from, ChordProgression &to) const;
 
     /**
      * This function posts the constraints for an alteration modulation. It ensures that the first tonality ends on a diatonic
      * chord, and that the first chord of the new tonality contains at least one note not in the first tonality. It also
      * enforces that the V chord of the new tonality must be at the second or third position in the new tonality's section.
      * @param home the search space
+     * @param from the chord progression to modulate from
+     * @param to the chord progression to modulate to
      */
-    void alteration_modulation(Home home) const;
+    void alteration_modulation(Home home, ChordProgression &from, ChordProgression &to) const;
 
     /**
      * This function posts the constraints for a secondary dominant modulation. It ensures that the first chord of the new tonality
      * is the V chord, and that the last chord of the first tonality contains the note below the leading tone of the new tonality.
      * @param home the search space
+     * @param from the chord progression to modulate from
+     * @param to the chord progression to modulate to
      */
-    void secondary_dominant_modulation(const Home& home) const;
+    void secondary_dominant_modulation(const Home& home, ChordProgression &from, ChordProgression &to) const;
 
     /**
      * Returns a string with each of the object's field values as integers.
@@ -27,11 +27,12 @@
  * @param maxChromaticChords the maximum number of chromatic chords in the progression
  * @param minSeventhChords the minimum number of seventh chords in the progression
  * @param maxSeventhChords the maximum number of seventh chords in the progression
+ * @param options how the constraints are posted in the model
  */
-void tonal_progression(const Home& home, int size, Tonality *tonality, IntVarArray &states, IntVarArray &qualities,
-                       IntVarArray &rootNotes, IntVarArray &chords, IntVarArray &bassDegrees, IntVarArray &isChromatic,
-                       IntVarArray &hasSeventh, const IntVarArray& roots, const IntVarArray& thirds, const IntVarArray& fifths,
+void tonal_progression(const Home& home, int size, Tonality *tonality, const IntVarArray &states, const IntVarArray &qualities,
+                       const IntVarArray &rootNotes, const IntVarArray &chords, const IntVarArray &bassDegrees, const IntVarArray &isChromatic,
+                       const IntVarArray &hasSeventh, const IntVarArray& roots, const IntVarArray& thirds, const IntVarArray& fifths,
                        const IntVarArray& sevenths, int minChromaticChords, int maxChromaticChords, int minSeventhChords,
-                       int maxSeventhChords);
+                       int maxSeventhChords, const ModelOptions& options);
 
 #endif //CHORDGENERATOR_MUSICALPARTS_HPP
@@ -0,0 +1,56 @@
+//
+// Created on 16/10/2026.
+//
+
+#ifndef CHORDGENERATOR_RESOLVESESSION_HPP
+#define CHORDGENERATOR_RESOLVESESSION_HPP
+
+#include "HarmoniserSolver.hpp"
+
+#include <memory>
+
+/**
+ * This class allows re-solving windows of a solved piece, e.g. to propose another option for a few bars while the rest
+ * of the piece is kept. The model of the piece is posted and propagated once, when the session is created. Each
+ * re-solve clones this root space, fixes the chords of the current solution outside of the window and searches only
+ * the window. The constraints that cross the edges of the window (chord transitions, tritone resolutions, modulations,
+ * ...) are part of the root space, so they still hold with the fixed neighbours.
+ */
+class ResolveSession {
+private:
+    TonalPieceParameters* parameters;           /// the parameters of the piece
+    std::unique_ptr<TonalPiece> root;           /// the propagated model, without branching
+    HarmoniserSolution solution;                /// the current solution
+    unsigned int seed;                          /// the seed of the next re-solve, changed at each one
+
+public:
+    /**
+     * Creates a session on a solution of the piece. The solution is checked against the model of the piece.
+     * @param params the parameters of the piece, they must outlive the session
+     * @param solution a solution of the piece
+     * @throws std::invalid_argument if the solution does not have the shape of the piece or violates its constraints
+     */
+    ResolveSession(TonalPieceParameters* params, HarmoniserSolution solution);
+
+    /**
+     * Creates a session and solves the piece with solve_harmoniser
+     * @param params the parameters of the piece, they must outlive the session
+     * @param options the search options
+     */
+    explicit ResolveSession(TonalPieceParameters* params, const HarmoniserOptions& options = HarmoniserOptions());
+
+    /**
+     * Re-solves a window of the piece. The chords outside of the window keep their values. If a new solution is found,
+     * it becomes the current solution.
+     * @param first the position of the first chord of the window
+     * @param last the position of the last chord of the window
+     * @param different if true, the window must differ from the current solution on at least one chord
+     * @param options the search options, typically with a time limit for interactive uses
+     * @return true if a new solution was found
+     */
+    bool resolve(int first, int last, bool different = true, const HarmoniserOptions& options = HarmoniserOptions());
+
+    const HarmoniserSolution& get_solution() const { return solution; }
+};
+
+#endif //CHORDGENERATOR_RESOLVESESSION_HPP
@@ -0,0 +1,73 @@
+//
+// Created on 16/10/2026.
+//
+
+#ifndef CHORDGENERATOR_ROLLINGGENERATOR_HPP
+#define CHORDGENERATOR_ROLLINGGENERATOR_HPP
+
+#include "HarmoniserSolver.hpp"
+
+/// A chord produced by the RollingGenerator
+struct GeneratedChord {
+    Tonality* tonality;     /// the tonality the degree is expressed in
+    int degree;             /// the degree of the chord in the tonality
+    int state;              /// the state of the chord
+    int quality;            /// the quality of the chord
+    int rootNote;           /// the root note of the chord
+};
+
+/**
+ * This class generates progressions of any length with a rolling horizon. Each call to next solves a piece of horizon
+ * chords, commits the first commit ones and forgets the rest. The next piece starts with the last two committed chords,
+ * fixed to their values, so that the rules on successive chords (transitions, tritone resolutions, preparations, ...)
+ * hold across the pieces. Only these chords and the current tonality are carried from one piece to the next, so the
+ * memory used and the time per chord do not depend on the number of chords generated.
+ *
+ * A modulation can be requested with modulate: it is placed at the beginning of the next piece, and it is committed
+ * along with enough chords in the new tonality to carry. The limits on the number of chromatic and seventh chords apply
+ * to each piece.
+ */
+class RollingGenerator {
+private:
+    Tonality* tonality;                     /// the current tonality
+    int horizon;                            /// the number of new chords in each piece
+    int commit;                             /// the number of chords committed after each piece
+    HarmoniserOptions options;              /// the search options of each piece
+    ModelOptions modelOptions;              /// how the constraints are posted in each piece
+
+    vector<GeneratedChord> carried;         /// the last committed chords, at the beginning of the next piece
+    Tonality* nextTonality;                 /// the tonality to modulate to in the next piece, nullptr if none
+    int nextModulation;                     /// the type of the next modulation
+    unsigned long generated;                /// the number of chords committed so far
+
+public:
+    /**
+     * Constructor
+     * @param tonality the tonality of the first chords
+     * @param horizon the number of new chords in each piece
+     * @param commit the number of chords committed after each piece, at most horizon
+     * @param options the search options of each piece, the portfolio and LNS modes are not supported
+     * @param modelOptions how the constraints are posted in each piece
+     */
+    RollingGenerator(Tonality* tonality, int horizon, int commit, const HarmoniserOptions& options = HarmoniserOptions(),
+                     const ModelOptions& modelOptions = ModelOptions());
+
+    /**
+     * Requests a modulation at the beginning of the next piece
+     * @param to the new tonality
+     * @param modulationType the type of the modulation
+     */
+    void modulate(Tonality* to, int modulationType);
+
+    /**
+     * Solves the next piece and commits its first chords
+     * @return the committed chords
+     */
+    vector<GeneratedChord> next();
+
+    Tonality* get_tonality() const { return tonality; }
+
+    unsigned long get_generated() const { return generated; }
+};
+
+#endif //CHORDGENERATOR_ROLLINGGENERATOR_HPP
@@ -0,0 +1,95 @@
+//
+// Created on 16/10/2026.
+//
+
+#ifndef CHORDGENERATOR_SOLUTIONCACHE_HPP
+#define CHORDGENERATOR_SOLUTIONCACHE_HPP
+
+#include "HarmoniserSolver.hpp"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * This class is an in-memory cache of solved pieces that is invariant by transposition. The degrees, states and
+ * qualities of a solution are relative to the tonalities of the piece, only the root notes depend on the actual tonics.
+ * A piece is thus identified by its canonical key (see canonical_key), in which the tonics are expressed as intervals
+ * from the first one, and a cached solution is served for any transposition of the piece by transposing its root notes.
+ *
+ * The cache holds at most capacity solutions, and evicts the least recently used one when it is full. It can be shared
+ * by several threads.
+ */
+class SolutionCache {
+private:
+    /// A cached solution, with the tonic of the first tonality of the piece it was computed for
+    struct Entry {
+        string key;
+        int tonic;
+        HarmoniserSolution solution;
+    };
+
+    size_t capacity;                                                    /// the maximal number of solutions
+    std::list<Entry> entries;                                           /// the solutions, most recently used first
+    std::unordered_map<string, std::list<Entry>::iterator> index;       /// the position of each key in entries
+    unsigned long hits;                                                 /// the number of successful lookups
+    unsigned long misses;                                               /// the number of failed lookups
+    mutable std::mutex mutex;
+
+public:
+    /**
+     * Constructor
+     * @param capacity the maximal number of solutions in the cache
+     */
+    explicit SolutionCache(size_t capacity = 4096);
+
+    /**
+     * Returns the canonical key of a piece: its size, the mode of each tonality and the interval between its tonic and
+     * the first tonic, the type, start and end of each modulation, the soft rules, the model options and the search
+     * options that change the solution found (the seed, the optimisation, and the restarts with their cutoff sequence
+     * and nogoods).
+     * @param params the parameters of the piece
+     * @param options the search options
+     * @return the canonical key
+     */
+    static string canonical_key(const TonalPieceParameters& params, const HarmoniserOptions& options);
+
+    /**
+     * Looks for a solution of the piece or one of its transpositions. If one is found, its root notes are transposed
+     * to the tonics of the piece.
+     * @param params the parameters of the piece
+     * @param options the search options
+     * @param solution the solution, set if one is found
+     * @return true if a solution was found
+     */
+    bool lookup(const TonalPieceParameters& params, const HarmoniserOptions& options, HarmoniserSolution& solution);
+
+    /**
+     * Adds the solution of a piece to the cache, evicting the least recently used solution if the cache is full.
+     * @param params the parameters of the piece
+     * @param options the search options the solution was found with
+     * @param solution the solution
+     */
+    void insert(const TonalPieceParameters& params, const HarmoniserOptions& options, const HarmoniserSolution& solution);
+
+    size_t size() const;
+
+    unsigned long get_hits() const;
+
+    unsigned long get_misses() const;
+};
+
+/**
+ * Solves a piece with solve_harmoniser, unless a solution of the piece or one of its transpositions is in the cache. The
+ * piece is created from the parameters with the seed of the options, and its solution is added to the cache.
+ * @param params the parameters of the piece
+ * @param cache the solution cache
+ * @param solution the solution, set if one is found
+ * @param options the search options, the portfolio and LNS modes are not supported as their solutions are not
+ * reproducible
+ * @return true if a solution was found
+ */
+bool solve_harmoniser_cached(TonalPieceParameters* params, SolutionCache& cache, HarmoniserSolution& solution,
+                             const HarmoniserOptions& options = HarmoniserOptions());
+
+#endif //CHORDGENERATOR_SOLUTIONCACHE_HPP
@@ -0,0 +1,61 @@
+//
+// Created on 16/10/2026.
+//
+
+#ifndef CHORDGENERATOR_SOLUTIONCOUNTER_HPP
+#define CHORDGENERATOR_SOLUTIONCOUNTER_HPP
+
+#include "BigUInt.hpp"
+#include "HarmoniserSolver.hpp"
+#include "TonalityRegistry.hpp"
+
+/**
+ * Counts, indexes and samples the solutions of a piece without search. The rules of a tonal progression only involve
+ * one chord or two successive chords, except for the repetition of a degree which involves three, so the solutions are
+ * the paths of a layered graph whose nodes are a legal chord and whether its degree repeats the previous one. The
+ * number of paths from each node to the end of the piece is computed once, backwards, which gives the exact number of
+ * solutions, the k-th solution in lexicographic order and uniformly random solutions in linear time.
+ * Only pieces with a single tonality are supported, as the constraints of the modulations link chords that are further
+ * apart. The chords use the same rules as the CP model (see is_legal_chord and is_legal_succession).
+ */
+class SolutionCounter {
+private:
+    TonalPieceParameters*           parameters;
+    const TonalityTables*           tables;         /// the legal chords and successions of the tonality
+    vector<vector<int>>             successors;     /// the chords that can follow each chord, as indices in the tables
+    /// the number of ways to complete the piece after each position, for each node (2 * chord + whether it repeats)
+    vector<vector<BigUInt>>         completions;
+    BigUInt                         total;
+
+    HarmoniserSolution to_solution(const vector<int>& path) const;
+
+public:
+    /**
+     * Compiles the rules of the piece into the layered graph and counts its solutions
+     * @param params the parameters of a piece with a single tonality
+     */
+    explicit SolutionCounter(TonalPieceParameters* params);
+
+    /**
+     * Returns the number of solutions of the piece
+     * @return the exact number of solutions
+     */
+    const BigUInt& count() const { return total; }
+
+    /**
+     * Returns the solution at the given index, the solutions being ordered lexicographically on (degree, state,
+     * quality) from the first chord to the last
+     * @param index a number lower than count()
+     * @return the solution
+     */
+    HarmoniserSolution solution(BigUInt index) const;
+
+    /**
+     * Returns a solution drawn uniformly among all the solutions of the piece
+     * @param rng the random generator
+     * @return the solution
+     */
+    HarmoniserSolution sample(std::mt19937_64& rng) const;
+};
+
+#endif //CHORDGENERATOR_SOLUTIONCOUNTER_HPP
@@ -0,0 +1,109 @@
+//
+// Created on 16/10/2026.
+//
+
+#ifndef CHORDGENERATOR_SOLUTIONSTORE_HPP
+#define CHORDGENERATOR_SOLUTIONSTORE_HPP
+
+#include "SolutionCache.hpp"
+
+#include <cstdint>
+#include <mutex>
+
+/**
+ * This class is a persistent store of solved pieces, shared by the processes that open the same file. Like the
+ * SolutionCache, it is indexed by the canonical key of the pieces, so a solution is served for any transposition of the
+ * piece it was computed for.
+ *
+ * The file has a fixed layout and is mapped in memory as a whole, so opening it does not parse anything:
+ * - a header with the magic number, the version, the number of buckets, the size of the file, the end of the data and
+ *   the number of records;
+ * - a hash table of nBuckets buckets, each holding the FNV-1a hash of a key and the offset of its record (0 if empty),
+ *   with linear probing;
+ * - the records, appended one after the other. A record holds the key, the cost, the tonic of the first tonality, the
+ *   length of each progression, then the degrees, states, qualities and root notes as bytes.
+ * The size of the file is fixed when it is created, so the mapping never moves.
+ *
+ * Writers take an exclusive lock on the file. They write the record before publishing its offset in the bucket, so the
+ * readers never see a partial record and do not need any lock. The file lock belongs to the open file, which the threads
+ * of a process share, so the writers of a process are also serialised by a mutex: a store can be shared by several
+ * threads. The records are checked against the end of the data before they are read, so a corrupt or truncated file
+ * gives misses instead of reads outside of the mapping.
+ */
+class SolutionStore {
+private:
+    int fd;                         /// the file descriptor
+    uint8_t* data;                  /// the mapping of the whole file
+    size_t length;                  /// the size of the mapping
+    bool writable;                  /// whether the store was opened for writing
+    std::mutex mutex;               /// serialises the writers of this process, which share the file lock
+
+    /**
+     * Returns the bucket at the given index
+     * @param i the index of the bucket
+     * @return a pointer to the hash of the bucket, followed by the offset of its record
+     */
+    uint64_t* bucket(uint64_t i) const;
+
+    /**
+     * Looks for the bucket of a key
+     * @param key the canonical key
+     * @param hash the hash of the key
+     * @param offset the offset of the record of the key, 0 if it is not in the store
+     * @return the index of the bucket of the key, or of the first empty bucket on its probing sequence. -1 if the key
+     * is not in the store and the table is full.
+     */
+    int64_t find(const string& key, uint64_t hash, uint64_t& offset) const;
+
+public:
+    /**
+     * Opens a store, creating the file if it does not exist and the store is writable.
+     * @param path the path of the file
+     * @param writable whether solutions can be added to the store
+     * @param nBuckets the number of buckets of the hash table when the file is created
+     * @param capacity the size of the file in bytes when the file is created
+     */
+    explicit SolutionStore(const string& path, bool writable = false, uint32_t nBuckets = 1U << 16,
+                           size_t capacity = 64UL << 20);
+
+    ~SolutionStore();
+
+    SolutionStore(const SolutionStore&) = delete;
+    SolutionStore& operator=(const SolutionStore&) = delete;
+
+    /**
+     * Returns the 64 bits FNV-1a hash of a string
+     * @param key the string
+     * @return the hash
+     */
+    static uint64_t fnv1a(const string& key);
+
+    /**
+     * Looks for a solution of the piece or one of its transpositions. If one is found, its root notes are transposed
+     * to the tonics of the piece.
+     * @param params the parameters of the piece
+     * @param options the search options
+     * @param solution the solution, set if one is found
+     * @return true if a solution was found
+     */
+    bool lookup(const TonalPieceParameters& params, const HarmoniserOptions& options,
+                HarmoniserSolution& solution) const;
+
+    /**
+     * Adds the solution of a piece to the store, unless the piece is already in it.
+     * @param params the parameters of the piece
+     * @param options the search options the solution was found with
+     * @param solution the solution
+     * @return false if the store is full, true otherwise
+     */
+    bool insert(const TonalPieceParameters& params, const HarmoniserOptions& options,
+                const HarmoniserSolution& solution);
+
+    /**
+     * Returns the number of solutions in the store
+     * @return the number of records
+     */
+    uint64_t size() const;
+};
+
+#endif //CHORDGENERATOR_SOLUTIONSTORE_HPP
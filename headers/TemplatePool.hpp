@@ -0,0 +1,73 @@
+//
+// Created on 16/10/2026.
+//
+
+#ifndef CHORDGENERATOR_TEMPLATEPOOL_HPP
+#define CHORDGENERATOR_TEMPLATEPOOL_HPP
+
+#include "HarmoniserSolver.hpp"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * This class keeps propagated root spaces of pieces, so that the pieces that share a structure only post the model and
+ * propagate it once. A template is created for each structural key (see structural_key) and propagated without any
+ * branching. Each request then gets a clone of the template, on which it can set its seed, fix some chords and post its
+ * branching before solving it.
+ *
+ * The pool holds at most capacity templates, and evicts the least recently used one when it is full. It can be shared
+ * by several threads, the clones of a template are made one at a time as cloning reads and updates the template.
+ */
+class TemplatePool {
+private:
+    /// A propagated root space, with the parameters it was built from
+    struct Template {
+        string key;
+        std::unique_ptr<TonalPieceParameters> parameters;   /// a copy of the parameters using the registry tonalities
+        std::unique_ptr<TonalPiece> root;                   /// the propagated root space, nullptr if it failed
+        std::mutex mutex;                                   /// held while the root is cloned
+    };
+
+    size_t capacity;                                                                /// the maximal number of templates
+    std::list<std::shared_ptr<Template>> templates;                                 /// most recently used first
+    std::unordered_map<string, std::list<std::shared_ptr<Template>>::iterator> index;  /// the position of each key
+    unsigned long hits;                                                             /// the number of reused templates
+    unsigned long misses;                                                           /// the number of built templates
+    mutable std::mutex mutex;
+
+    static std::shared_ptr<Template> build(const TonalPieceParameters& params, string key);
+
+public:
+    /**
+     * Constructor
+     * @param capacity the maximal number of templates in the pool
+     */
+    explicit TemplatePool(size_t capacity = 256);
+
+    /**
+     * Returns the structural key of a piece: its size, the tonic and mode of each tonality, the type, start and end of
+     * each modulation, the soft rules and the model options. The pieces with the same key have the same model.
+     * @param params the parameters of the piece
+     * @return the structural key
+     */
+    static string structural_key(const TonalPieceParameters& params);
+
+    /**
+     * Returns a propagated piece for the parameters, cloned from the template of their structure. The template is built
+     * the first time the structure is requested. The piece has no branching and uses the default seed.
+     * @param params the parameters of the piece, they must outlive the piece
+     * @return the piece, owned by the caller, or nullptr if the model of the piece fails at the root
+     */
+    TonalPiece* acquire(TonalPieceParameters* params);
+
+    size_t size() const;
+
+    unsigned long get_hits() const;
+
+    unsigned long get_misses() const;
+};
+
+#endif //CHORDGENERATOR_TEMPLATEPOOL_HPP
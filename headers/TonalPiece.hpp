@@ -9,6 +9,27 @@
 #include "Modulation.hpp"
 #include "TonalPieceParameters.hpp"
 
+#include <atomic>
+#include <memory>
+
+/// The branching strategies that can be posted on a piece (see TonalPiece::post_branching)
+enum BranchingStrategy {
+    BRANCH_SIZE_RANDOM,         /// smallest domain first, random degree (the default)
+    BRANCH_AFC_RANDOM,          /// highest accumulated failure count over domain size first, random degree
+    BRANCH_INPUT_ORDER_MIN,     /// chords in order, smallest degree first
+    BRANCH_DEGREE_SPLIT,        /// most constrained chord over domain size first, lower half of the degrees first
+    N_BRANCHING_STRATEGIES
+};
+
+/// The windows of chords that can be relaxed by the large neighbourhood search (see TonalPiece::set_neighbourhood)
+enum NeighbourhoodType {
+    RANDOM_WINDOW,              /// any window of consecutive chords
+    PHRASE_WINDOW,              /// a window inside a phrase
+    MODULATION_WINDOW,          /// a window around a modulation
+    PROGRESSION_WINDOW,         /// a window inside the progression of a tonality
+    N_NEIGHBOURHOOD_TYPES
+};
+
 /**
  * This class represents a tonal piece. It can have multiple tonalities, with modulations between them. It extends
  * the Gecode::Space class to create the search space for the problem. This class does not directly post constraints,
@@ -23,6 +44,9 @@
  *
  * The following input is required to create the model: the size of the piece, the tonalities, the starting position and
  * ending position of each modulation, as well as their type.
+ *
+ * The ChordProgression and Modulation objects are held by value, so that cloning the space only updates the variable
+ * handles they contain.
  */
 class TonalPiece : public Space {
 private:
@@ -35,23 +59,48 @@ private:
     IntVarArray                     rootNotes;                   /// the root notes corresponding to the chord degrees
     IntVarArray                     hasSeventh;                  /// whether the chord has a seventh or not
 
-    /// Auxiliary variable array
+    /// Auxiliary variable array, not created in lean mode
     IntVarArray                     qualitiesWithoutSeventh;       /// the quality of the chords without the seventh
 
+    /// The cost of the piece, the weighted sum of the violations of the soft rules
+    IntVar                          cost;
+
     /// Problem objects for sections and modulations
-    vector<ChordProgression *>      progressions;                /// the chord progression objects for each tonality
-    vector<Modulation *>            modulations;                 /// the modulation objects for each modulation
+    vector<ChordProgression>        progressions;                /// the chord progression objects for each tonality
+    vector<Modulation>              modulations;                 /// the modulation objects for each modulation
+
+    /// Search parameters
+    int                             branching;                   /// the posted BranchingStrategy, -1 if none is posted yet
+    unsigned int                    seed;                        /// the seed of the random value selection
+    int                             neighbourhood;               /// the size of the windows relaxed at each restart, 0 if disabled
+
+    /// the number of clones made from this piece since the last reset, the counter is shared with the clones
+    std::shared_ptr<std::atomic<unsigned long>> clones;
+
+    /**
+     * Posts the soft rules of the parameters, and links their violations to the cost of the piece.
+     */
+    void post_soft_rules();
+
+    /**
+     * Fixes the chords of the incumbent solution outside of a window of the piece. The window is chosen at random among
+     * the NeighbourhoodType, and is at most neighbourhood chords long.
+     * @param incumbent the best solution found so far
+     * @param restart the number of the restart, used to draw the window
+     */
+    void relax(const TonalPiece& incumbent, unsigned long restart);
 
 public:
     /**
      * Constructor for TonalPiece objects.
      * It initializes the variable arrays, and links the auxiliary array to the main ones. Assuming the parameters are
      * correct, it computes the starting position and duration of each tonality, and creates the ChordProgression and
-     * Modulation objects. It also posts the branching. It is done in this order: First, branch on the chord degrees
-     * for each tonality, then branch on states and qualities if necessary.
+     * Modulation objects. It also posts the default branching (see post_branching), unless postBranching is false.
      * @param params a TonalPieceParameters object that contains the parameters for the piece
+     * @param postBranching whether to post the default branching, it can be posted later otherwise
+     * @param seed the seed of the random value selection of the branching (see set_seed)
      */
-    explicit TonalPiece(TonalPieceParameters* params);
+    explicit TonalPiece(TonalPieceParameters* params, bool postBranching = true, unsigned int seed = 1U);
 
     /**
      * @brief Copy constructor
@@ -62,19 +111,115 @@ public:
 
     TonalPieceParameters* getParameters() const { return parameters; };
 
+    /**
+     * Replaces the parameters of the piece by equivalent ones, that have the same structure (see
+     * TemplatePool::structural_key). It is used to hand out the clones of a shared piece to requests that own their
+     * parameters.
+     * @param params the new parameters, they must outlive the piece
+     */
+    void set_parameters(TonalPieceParameters* params) { parameters = params; }
+
+    bool has_branching() const { return branching >= 0; }
+
+    unsigned int get_seed() const { return seed; }
+
+    /**
+     * Sets the seed of the random value selection. It must be called before the branching is posted.
+     * @param s the seed
+     */
+    void set_seed(unsigned int s) { seed = s; }
+
+    int get_neighbourhood() const { return neighbourhood; }
+
+    /**
+     * Enables the large neighbourhood search: after each restart with a solution, only a window of size chords is left
+     * free, the other chords keep their values in the best solution found so far (see relax).
+     * @param size the size of the windows, 0 to disable the large neighbourhood search
+     */
+    void set_neighbourhood(int size) { neighbourhood = size; }
+
+    /**
+     * Posts the branching. It is done in this order: First, branch on the chord degrees for each tonality with the
+     * given strategy, then branch on states and qualities if necessary. The branching can only be posted once.
+     * @param strategy a BranchingStrategy
+     */
+    void post_branching(int strategy = BRANCH_SIZE_RANDOM);
+
+    /**
+     * Called by the search engines on the copy of the space that they explore. In a portfolio, each asset posts a
+     * different branching strategy with a different seed. When restarting with a large neighbourhood, the incumbent
+     * solution is fixed outside of a window.
+     * @param mi the information about the restart or the portfolio asset
+     * @return false if only a neighbourhood is explored, true if the search in the slave is complete
+     */
+    bool slave(const MetaInfo& mi) override;
+
+    /**
+     * Fixes the chords of a solution outside of the given windows. The windows are left free, so that a search only has
+     * to find their chords, e.g. to join solutions of parts of the piece.
+     * @param degrees the chord degrees of each progression
+     * @param states the state of each chord of the piece
+     * @param qualities the quality of each chord of the piece
+     * @param windows the first and last positions of each window that stays free
+     */
+    void fix(const vector<vector<int>>& degrees, const vector<int>& states, const vector<int>& qualities,
+             const vector<std::pair<int, int>>& windows);
+
+    /**
+     * Constrains the cost of the piece to be strictly lower than the cost of the best solution found so far. It is
+     * called by the branch and bound search engines.
+     * @param best the best solution found so far
+     */
+    void constrain(const Space& best) override;
+
     IntVarArray getStates() const { return states; };
 
     IntVarArray getQualities() const { return qualities; };
 
     IntVarArray getRootNotes() const { return rootNotes; };
 
+    /// In lean mode, the following arrays are empty (see ChordProgression::values)
     IntVarArray getHasSeventh() const { return hasSeventh; };
 
     IntVarArray getQualityWithoutSeventh() const { return qualitiesWithoutSeventh; };
 
-    ChordProgression *getChordProgression(int pos) const { return progressions[pos]; };
+    /**
+     * Returns the cost of the piece, i.e. the sum of the weights of the violated soft rules. It is 0 if the parameters
+     * contain no soft rule.
+     * @return the cost variable
+     */
+    IntVar getCost() const { return cost; }
+
+    ChordProgression *getChordProgression(int pos) { return &progressions[pos]; };
 
-    Modulation *getModulation(int pos) const { return modulations[pos]; };
+    const ChordProgression *getChordProgression(int pos) const { return &progressions[pos]; };
+
+    const Modulation *getModulation(int pos) const { return &modulations[pos]; };
+
+    /**
+     * Returns the number of bytes used by a clone of this space: the memory allocated by Gecode for the variables and
+     * propagators, the object itself and the arrays of progressions and modulations.
+     * @return the size of a clone in bytes
+     */
+    size_t clone_size() const;
+
+    /**
+     * Returns the number of clones made since the last call to reset_clones on this piece or the piece it was cloned from
+     * @return the number of clones
+     */
+    unsigned long get_clones() const { return clones->load(); }
+
+    /**
+     * Gives the piece a new clone counter, shared with the clones made from it afterwards. The other pieces keep their
+     * counter, so that concurrent searches count their clones separately.
+     */
+    void reset_clones() { clones = std::make_shared<std::atomic<unsigned long>>(0); }
+
+    /**
+     * Returns the clone counter of the piece, which outlives the piece and its clones as long as it is held
+     * @return the shared counter
+     */
+    const std::shared_ptr<std::atomic<unsigned long>>& get_clone_counter() const { return clones; }
 
     /**
      * Returns a string with each of the object's field values as integers.
@@ -25,6 +25,9 @@ protected:
     vector<int> phraseStarts;
     vector<int> phraseEnds;
 
+    ModelOptions modelOptions;      /// how the constraints are posted in the model
+    vector<SoftRule> softRules;     /// the weighted rules that make up the cost of a solution
+
 public:
     /**
      * Constructor
@@ -59,6 +62,19 @@ public:
 
     int         get_phraseEnd(const int index) const            { return phraseEnds[index]; }
 
+    const ModelOptions& get_modelOptions() const                { return modelOptions; }
+
+    const vector<SoftRule>& get_softRules() const               { return softRules; }
+
+    /**                        setters                        **/
+    void        set_modelOptions(const ModelOptions& options)   { modelOptions = options; }
+
+    /**
+     * Adds a weighted soft rule to the piece. The rules are posted when the TonalPiece is created.
+     * @param rule a SoftRule
+     */
+    void        add_softRule(const SoftRule& rule);
+
 
     /**
      * ToString method
@@ -0,0 +1,75 @@
+//
+// Created on 16/10/2026.
+//
+
+#ifndef CHORDGENERATOR_TONALITYREGISTRY_HPP
+#define CHORDGENERATOR_TONALITYREGISTRY_HPP
+
+#include "ChordGeneratorUtilities.hpp"
+
+#include <array>
+#include <bitset>
+#include <memory>
+
+/// The maximal number of legal chords in a tonality, with the states and qualities allowed in TonalPiece
+constexpr int maxLegalChords = nSupportedChords * (THIRD_INVERSION + 1) * nSimpleQualities;
+/// A set of legal chords of a tonality, as indices in TonalityTables::chords
+using ChordSet = std::bitset<maxLegalChords>;
+
+/**
+ * The tables derived from a tonality that are used to post the constraints. They are computed once by the registry and
+ * never modified afterwards, so they can be shared by all the pieces and all the threads.
+ */
+struct TonalityTables {
+    Tonality* tonality;                 /// the tonality the tables are computed for
+    IntArgs degreeNotes;                /// the root note of each degree (link_root_notes_to_degrees)
+    const IntArgs* degreeQualities;     /// the qualities allowed for each degree in the mode (link_chords_to_qualities)
+    IntArgs noteToDegree;               /// the degree of each note, notes outside of the tonality get a fake degree above VII
+    IntArgs alterationNotes;            /// the notes of the diatonic degrees followed by the other notes (alteration modulation)
+    IntArgs alterationQualities;        /// the quality of each note in alterationNotes, -1 if it has no degree
+    TupleSet chordTable;                /// the legal tuples for a chord in the tonality (see chord_table)
+    TupleSet leanChordTable;            /// the chord table without the auxiliary variables (see lean_chord_table)
+    DFA transitionsAutomaton;           /// the automaton for the chord successions in the mode (see chord_transitions_automaton)
+    vector<std::array<int, 3>> chords;  /// the legal chords as {degree, state, quality} (see is_legal_chord)
+    vector<ChordSet> successors;        /// the chords that can follow each chord (see is_legal_succession)
+    vector<ChordSet> sameDegree;        /// the chords that have the same degree as each chord
+};
+
+/**
+ * This class holds the 24 major and minor tonalities along with their derived tables. It is created the first time it is
+ * used and lives until the end of the program. Its content is never modified after its creation, so it can be read
+ * without locking from several threads. The tonalities returned by get can be used in the parameters of the pieces
+ * instead of allocating new ones.
+ */
+class TonalityRegistry {
+private:
+    std::unique_ptr<MajorTonality> majorTonalities[PERFECT_OCTAVE];    /// the major tonalities indexed by tonic
+    std::unique_ptr<MinorTonality> minorTonalities[PERFECT_OCTAVE];    /// the minor tonalities indexed by tonic
+    std::unique_ptr<TonalityTables> tables[2][PERFECT_OCTAVE];         /// the derived tables indexed by mode and tonic
+
+    TonalityRegistry();
+
+    static const TonalityRegistry& instance();
+
+public:
+    TonalityRegistry(const TonalityRegistry&) = delete;
+    TonalityRegistry& operator=(const TonalityRegistry&) = delete;
+
+    /**
+     * Returns the tonality with the given tonic and mode from the registry
+     * @param tonic the tonic of the tonality
+     * @param mode the mode of the tonality (MAJOR_MODE or MINOR_MODE)
+     * @return the shared tonality object
+     */
+    static Tonality* get(int tonic, int mode);
+
+    /**
+     * Returns the tables derived from a tonality. The tonality does not need to come from the registry, the tables are
+     * found from its tonic and mode.
+     * @param tonality a tonality
+     * @return the shared tables of the tonality
+     */
+    static const TonalityTables& get_tables(const Tonality* tonality);
+};
+
+#endif //CHORDGENERATOR_TONALITYREGISTRY_HPP
@@ -0,0 +1,58 @@
+//
+// Created on 16/10/2026.
+//
+
+#ifndef CHORDGENERATOR_VOICINGPIPELINE_HPP
+#define CHORDGENERATOR_VOICINGPIPELINE_HPP
+
+#include "HarmoniserSolver.hpp"
+
+#include <memory>
+
+/// The options of solve_pipeline, the search options of the progressions are given separately
+struct PipelineOptions {
+    unsigned int voicingWorkers = 0;        /// the number of threads voicing the progressions, 0 for one per core but one
+    size_t queueCapacity = 4;               /// the maximal number of progressions waiting to be voiced
+    unsigned int wanted = 1;                /// the number of voiced pieces after which the pipeline stops
+    unsigned long maxCandidates = 0;        /// the maximal number of progressions produced, 0 for no limit
+    unsigned int voicingTimeLimit = 60000;  /// the time limit of the voicing of each progression, in milliseconds
+};
+
+/// The parameters of the four voice texture problem of a progression, with the parameters of its sections and modulations
+struct DiatonyParameters {
+    vector<std::unique_ptr<TonalProgressionParameters>> sections;   /// the parameters of each progression
+    vector<std::unique_ptr<ModulationParameters>> modulations;      /// the parameters of each modulation
+    std::unique_ptr<FourVoiceTextureParameters> piece;              /// the parameters given to solve_diatony
+};
+
+/// A progression and its four voice texture
+struct VoicedPiece {
+    HarmoniserSolution progression;                 /// the progression given to Diatony
+    std::unique_ptr<DiatonyParameters> parameters;  /// the parameters of the voicing, which refers to them
+    std::unique_ptr<FourVoiceTexture> voicing;      /// the solution of Diatony
+};
+
+/**
+ * Creates the parameters of the four voice texture problem for a solution of the progression problem: the degrees,
+ * states and qualities of each progression, and the modulations of the piece.
+ * @param params the parameters of the piece
+ * @param solution a solution of the piece
+ * @return the parameters for solve_diatony, along with the parameters of the sections and modulations they refer to
+ */
+std::unique_ptr<DiatonyParameters> to_diatony_parameters(const TonalPieceParameters& params,
+                                                         const HarmoniserSolution& solution);
+
+/**
+ * Generates progressions and voices them with Diatony concurrently. The calling thread enumerates the progressions of the
+ * piece (see enumerate_harmoniser) into a bounded queue, and blocks when the queue is full. The voicing workers take
+ * the progressions from the queue and solve their four voice texture, so that a progression that cannot be voiced only
+ * costs its own voicing. Once enough pieces are voiced, the enumeration and the running voicings are stopped.
+ * @param params the parameters of the piece
+ * @param pipeline the options of the pipeline
+ * @param options the search options of the progressions, the restart, LNS and portfolio modes are not supported
+ * @return the voiced pieces, at most pipeline.wanted of them
+ */
+vector<VoicedPiece> solve_pipeline(TonalPieceParameters* params, const PipelineOptions& pipeline = PipelineOptions(),
+                                   const HarmoniserOptions& options = HarmoniserOptions());
+
+#endif //CHORDGENERATOR_VOICINGPIPELINE_HPP
@@ -0,0 +1,133 @@
+//
+// Created on 16/10/2026.
+//
+
+#include "../headers/BigUInt.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+BigUInt::BigUInt(const uint64_t value) {
+    if (value > 0)
+        limbs.push_back(static_cast<uint32_t>(value));
+    if (value >> 32 > 0)
+        limbs.push_back(static_cast<uint32_t>(value >> 32));
+}
+
+void BigUInt::trim() {
+    while (!limbs.empty() && limbs.back() == 0)
+        limbs.pop_back();
+}
+
+BigUInt& BigUInt::operator+=(const BigUInt& other) {
+    if (limbs.size() < other.limbs.size())
+        limbs.resize(other.limbs.size(), 0);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < limbs.size(); i++) {
+        const uint64_t sum = static_cast<uint64_t>(limbs[i]) + (i < other.limbs.size() ? other.limbs[i] : 0) + carry;
+        limbs[i] = static_cast<uint32_t>(sum);
+        carry = sum >> 32;
+    }
+    if (carry > 0)
+        limbs.push_back(static_cast<uint32_t>(carry));
+    return *this;
+}
+
+/**
+ * Subtracts a number that is not larger than this one
+ * @param other the number to subtract
+ * @return this number
+ */
+BigUInt& BigUInt::operator-=(const BigUInt& other) {
+    if (*this < other)
+        throw std::underflow_error("BigUInt subtraction would be negative");
+    int64_t borrow = 0;
+    for (size_t i = 0; i < limbs.size(); i++) {
+        int64_t diff = static_cast<int64_t>(limbs[i]) - (i < other.limbs.size() ? other.limbs[i] : 0) - borrow;
+        borrow = diff < 0 ? 1 : 0;
+        if (diff < 0)
+            diff += static_cast<int64_t>(1) << 32;
+        limbs[i] = static_cast<uint32_t>(diff);
+    }
+    trim();
+    return *this;
+}
+
+bool BigUInt::operator<(const BigUInt& other) const {
+    if (limbs.size() != other.limbs.size())
+        return limbs.size() < other.limbs.size();
+    for (size_t i = limbs.size(); i-- > 0;)
+        if (limbs[i] != other.limbs[i])
+            return limbs[i] < other.limbs[i];
+    return false;
+}
+
+/**
+ * Returns the decimal logarithm of the number, e.g. to compare numbers of solutions that do not fit in a double
+ * @return the logarithm, -infinity for 0
+ */
+double BigUInt::log10() const {
+    if (limbs.empty())
+        return -INFINITY;
+    /// the two most significant limbs are enough for the precision of a double
+    double top = limbs.back();
+    if (limbs.size() > 1)
+        top = top * 4294967296.0 + limbs[limbs.size() - 2];
+    const size_t shifted = limbs.size() > 1 ? limbs.size() - 2 : 0;
+    return std::log10(top) + static_cast<double>(shifted) * 32 * std::log10(2.0);
+}
+
+/**
+ * Returns the decimal representation of the number
+ * @return the digits of the number
+ */
+std::string BigUInt::to_string() const {
+    if (limbs.empty())
+        return "0";
+    /// divide by 10^9 repeatedly, each remainder gives 9 digits
+    std::vector<uint32_t> n = limbs;
+    std::vector<uint32_t> chunks;
+    while (!n.empty()) {
+        uint64_t remainder = 0;
+        for (size_t i = n.size(); i-- > 0;) {
+            const uint64_t current = (remainder << 32) | n[i];
+            n[i] = static_cast<uint32_t>(current / 1000000000);
+            remainder = current % 1000000000;
+        }
+        chunks.push_back(static_cast<uint32_t>(remainder));
+        while (!n.empty() && n.back() == 0)
+            n.pop_back();
+    }
+    std::string txt = std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- > 0;) {
+        const std::string digits = std::to_string(chunks[i]);
+        txt += std::string(9 - digits.size(), '0') + digits;
+    }
+    return txt;
+}
+
+/**
+ * Draws a number uniformly between 0 (included) and bound (excluded)
+ * @param bound a positive number
+ * @param rng the random generator
+ * @return the random number
+ */
+BigUInt BigUInt::random_below(const BigUInt& bound, std::mt19937_64& rng) {
+    if (bound.is_zero())
+        throw std::invalid_argument("The bound of a random number must be positive");
+    /// draw numbers with as many bits as the bound until one is below it, which takes less than 2 draws on average
+    int topBits = 0;
+    while (topBits < 32 && (bound.limbs.back() >> topBits) != 0)
+        topBits++;
+    const uint32_t topMask = topBits == 32 ? 0xFFFFFFFFU : (1U << topBits) - 1;
+    while (true) {
+        BigUInt r;
+        r.limbs.resize(bound.limbs.size());
+        for (auto& limb : r.limbs)
+            limb = static_cast<uint32_t>(rng());
+        r.limbs.back() &= topMask;
+        r.trim();
+        if (r < bound)
+            return r;
+    }
+}
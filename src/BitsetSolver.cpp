@@ -0,0 +1,160 @@
+//
+// Created on 16/10/2026.
+//
+
+#include "../headers/BitsetSolver.hpp"
+
+#include <chrono>
+
+/**
+ * Computes the chords that can be used at each position of the piece
+ * @param params the parameters of a piece with a single tonality
+ */
+BitsetSolver::BitsetSolver(TonalPieceParameters* params) : parameters(params), nodes(0), fails(0),
+                                                                   stopped(false) {
+    if (params->get_nProgressions() != 1)
+        throw std::invalid_argument("The bitset solver only supports pieces with a single tonality");
+    if (params->get_size() < 1)
+        throw std::invalid_argument("The bitset solver needs a piece with at least one chord");
+    tables = &TonalityRegistry::get_tables(params->get_tonality(0));
+
+    /// every legal chord can end the piece, before that a chord needs a successor in the next position. The repetition
+    /// of degrees is left to the search, so the support can be larger than the chords that have a solution.
+    const int size = params->get_size();
+    const int n = static_cast<int>(tables->chords.size());
+    support.assign(size, ChordSet());
+    for (int a = 0; a < n; a++)
+        support[size - 1].set(a);
+    for (int i = size - 2; i >= 0; i--)
+        for (int a = 0; a < n; a++)
+            if ((tables->successors[a] & support[i + 1]).any())
+                support[i].set(a);
+}
+
+/**
+ * Explores the search tree and passes each solution to the sink
+ * @param sink the function receiving the solutions, it returns false to stop the search
+ * @param maxSolutions the maximal number of solutions, 0 for all of them
+ * @param seed the seed of the random chord selection, 0 to try the chords in the order of the tables
+ * @param failLimit the maximal number of dead ends, 0 for no limit
+ * @param timeLimit the time limit of the search in milliseconds, 0 for none
+ * @return the number of solutions passed to the sink
+ */
+unsigned long BitsetSolver::search(const SolutionSink& sink, const unsigned long maxSolutions, const unsigned int seed,
+                                   const unsigned long failLimit, const unsigned int timeLimit) {
+    const int size = parameters->get_size();
+    const int n = static_cast<int>(tables->chords.size());
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeLimit);
+    std::mt19937 rng(seed);
+    nodes = 0;      fails = 0;      stopped = false;
+    unsigned long nSolutions = 0;
+
+    /// domains[i] holds the chords that have not been tried yet at position i
+    vector<ChordSet> domains(size);
+    vector<int> path(size, -1);
+    domains[0] = support[0];
+    int i = 0;
+    while (i >= 0) {
+        if (domains[i].none()) {            /// every chord was tried, go back to the previous position
+            i--;
+            continue;
+        }
+        /// the clock is only read every 1024 nodes, a node takes a few nanoseconds
+        if (timeLimit > 0 && (nodes & 1023) == 0 && std::chrono::steady_clock::now() > deadline) {
+            stopped = true;
+            break;
+        }
+        /// take the first remaining chord, or a random one
+        int skip = seed == 0 ? 0 : static_cast<int>(rng() % domains[i].count());
+        int c = 0;
+        while (c < n && (!domains[i].test(c) || skip-- > 0))
+            c++;
+        domains[i].reset(c);
+        path[i] = c;
+        nodes++;
+
+        if (i == size - 1) {                /// a solution, the next one is looked for from the last chord
+            HarmoniserSolution solution;
+            solution.degrees.emplace_back();
+            for (const int chord : path) {
+                solution.degrees[0] .push_back(tables->chords[chord][0]);
+                solution.states     .push_back(tables->chords[chord][1]);
+                solution.qualities  .push_back(tables->chords[chord][2]);
+                solution.rootNotes  .push_back(tables->degreeNotes[tables->chords[chord][0]]);
+            }
+            solution.cost = solution.soft_rules_cost(*parameters);
+            nSolutions++;
+            if (!sink(solution) || nSolutions == maxSolutions)
+                break;
+            continue;
+        }
+
+        /// forward checking: the next chord follows this one, and the same degree cannot happen three times in a row
+        ChordSet next = tables->successors[c] & support[i + 1];
+        if (i > 0 && tables->chords[path[i - 1]][0] == tables->chords[c][0])
+            next &= ~tables->sameDegree[c];
+        if (next.none()) {
+            if (++fails == failLimit) {
+                stopped = true;
+                break;
+            }
+            continue;
+        }
+        domains[++i] = next;
+    }
+    return nSolutions;
+}
+
+/**
+ * Searches for a solution of the piece. With a seed of 0, the chords are tried in the order of the tables, otherwise
+ * they are chosen at random, like the BRANCH_SIZE_RANDOM branching of TonalPiece.
+ * @param solution the solution, set if one is found
+ * @param seed the seed of the random chord selection
+ * @param failLimit the maximal number of dead ends, 0 for no limit
+ * @param timeLimit the time limit of the search in milliseconds, 0 for none
+ * @return true if a solution was found
+ */
+bool BitsetSolver::solve(HarmoniserSolution& solution, const unsigned int seed, const unsigned long failLimit,
+                         const unsigned int timeLimit) {
+    const auto keep = [&solution](const HarmoniserSolution& sol) { solution = sol; return false; };
+    return search(keep, 1, seed, failLimit, timeLimit) == 1;
+}
+
+/**
+ * Enumerates the solutions of the piece, with the chords tried in the order of the tables
+ * @param sink the function receiving the solutions, it returns false to stop the enumeration
+ * @param maxSolutions the maximal number of solutions, 0 for all of them
+ * @param timeLimit the time limit of the enumeration in milliseconds, 0 for none
+ * @return the number of solutions passed to the sink
+ */
+unsigned long BitsetSolver::enumerate(const SolutionSink& sink, const unsigned long maxSolutions,
+                                      const unsigned int timeLimit) {
+    return search(sink, maxSolutions, 0, 0, timeLimit);
+}
+
+/**
+ * Finds a solution of a piece with the BitsetSolver when it has a single tonality, and with solve_harmoniser otherwise
+ * or when the options ask for something the BitsetSolver cannot do (optimisation, portfolio, LNS or restarts).
+ * @param params the parameters of the piece
+ * @param solution the solution, set if one is found
+ * @param options the search options, the seed and the time and fail limits are used by both solvers
+ * @return true if a solution was found
+ */
+bool solve_harmoniser_fast(TonalPieceParameters* params, HarmoniserSolution& solution,
+                           const HarmoniserOptions& options) {
+    if (params->get_nProgressions() == 1 && !options.optimise && !options.portfolio && !options.lns &&
+        !options.restarts) {
+        BitsetSolver solver(params);
+        return solver.solve(solution, options.seed, options.failLimit, options.timeLimit);
+    }
+
+    auto piece = new TonalPiece(params, false);
+    piece->set_seed(options.seed);
+    piece->post_branching(BRANCH_SIZE_RANDOM);
+    const auto sol = solve_harmoniser(piece, false, options);
+    if (sol == nullptr)
+        return false;
+    solution = HarmoniserSolution(*sol);
+    delete sol;
+    return true;
+}
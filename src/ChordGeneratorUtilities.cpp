@@ -4,6 +4,13 @@
 
 #include "../headers/ChordGeneratorUtilities.hpp"
 
+const IntArgs tonalTransitions(nSupportedChords * nSupportedChords, tonalTransitionsMatrix);
+const IntArgs degreeStates(nSupportedChords * nSupportedStates, degreeStatesMatrix);
+const IntArgs majorDegreeQualities(nSupportedChords * nSupportedQualities, majorDegreeQualitiesMatrix);
+const IntArgs minorDegreeQualities(nSupportedChords * nSupportedQualities, minorDegreeQualitiesMatrix);
+const IntArgs bassBasedOnDegreeAndState(nSupportedChords * nSupportedStates, bassBasedOnDegreeAndStateMatrix);
+const IntArgs simpleQualities(nSimpleQualities, simpleQualitiesMatrix);
+
 /**
  * Converts an IntVarArray to a pointer to an array of integers.
  * @param vars The IntVarArray to convert.
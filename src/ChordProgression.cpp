@@ -20,13 +20,14 @@
  * @param maxPercentChromaticChords the maximum percentage of chromatic chords in the progression
  * @param minPercentSeventhChords the minimum percentage of seventh chords in the progression
  * @param maxPercentSeventhChords the maximum percentage of seventh chords in the progression
+ * @param options how the constraints are posted in the model
  * @return a ChordProgression object
  */
 ChordProgression::
 ChordProgression(Home home, const int start, const int duration, Tonality *tonality, IntVarArray states, IntVarArray qualities,
                  IntVarArray qualitiesWithoutSeventh, IntVarArray rootNotes, IntVarArray hasSeventh,
                  const double minPercentChromaticChords, const double maxPercentChromaticChords, const double minPercentSeventhChords,
-                 const double maxPercentSeventhChords) {
+                 const double maxPercentSeventhChords, const ModelOptions& options) {
 
     this->start                     = start;
     this->duration                  = duration;
@@ -36,27 +37,31 @@ ChordProgression(Home home, const int start, const int duration, Tonality *tonal
     this->maxSeventhChords          = static_cast<int>(maxPercentSeventhChords * duration);
 
     this->tonality                  = tonality;
+    this->lean                      = options.leanSpace;
 
     this->chords                    = IntVarArray(home, duration,   FIRST_DEGREE, AUGMENTED_SIXTH);
     this->states                    = IntVarArray(home, states          .slice(start, 1, duration));
     this->qualities                 = IntVarArray(home, qualities       .slice(start, 1, duration));
-    this->qualitiesWithoutSeventh   = IntVarArray(home, qualitiesWithoutSeventh   .slice(start, 1, duration));
-    this->bassDegrees               = IntVarArray(home, duration,   FIRST_DEGREE, SEVENTH_DEGREE);
     this->rootNotes                 = IntVarArray(home, rootNotes       .slice(start, 1, duration));
 
-    this->roots                 = IntVarArray(home, duration, FIRST_DEGREE,             SEVENTH_DEGREE);
-    this->thirds                = IntVarArray(home, duration, FIRST_DEGREE,             SEVENTH_DEGREE);
-    this->fifths                = IntVarArray(home, duration, FIRST_DEGREE,             SEVENTH_DEGREE);
-    this->sevenths              = IntVarArray(home, duration, FIRST_DEGREE,             SEVENTH_DEGREE);
+    if (!lean) { /// the auxiliary arrays and the global arrays they are sliced from only exist in the full model
+        this->qualitiesWithoutSeventh   = IntVarArray(home, qualitiesWithoutSeventh   .slice(start, 1, duration));
+        this->bassDegrees               = IntVarArray(home, duration,   FIRST_DEGREE, SEVENTH_DEGREE);
 
-    this->isChromatic               = IntVarArray (home, duration, 0, 1);
-    this->hasSeventh                = IntVarArray (home, hasSeventh.slice(start, 1, duration));
+        this->roots                 = IntVarArray(home, duration, FIRST_DEGREE,             SEVENTH_DEGREE);
+        this->thirds                = IntVarArray(home, duration, FIRST_DEGREE,             SEVENTH_DEGREE);
+        this->fifths                = IntVarArray(home, duration, FIRST_DEGREE,             SEVENTH_DEGREE);
+        this->sevenths              = IntVarArray(home, duration, FIRST_DEGREE,             SEVENTH_DEGREE);
+
+        this->isChromatic               = IntVarArray (home, duration, 0, 1);
+        this->hasSeventh                = IntVarArray (home, hasSeventh.slice(start, 1, duration));
+    }
 
     /// constraints
     tonal_progression(home, this->duration, this->tonality, this->states, this->qualities, this->rootNotes,
                       chords, bassDegrees, isChromatic, this->hasSeventh, roots, thirds, fifths,
                       sevenths,
-                      minChromaticChords, maxChromaticChords, minSeventhChords, maxSeventhChords);
+                      minChromaticChords, maxChromaticChords, minSeventhChords, maxSeventhChords, options);
 
     /// Optional constraints
 }
@@ -75,6 +80,7 @@ ChordProgression::ChordProgression(Home home, ChordProgression &s){
     maxSeventhChords            = s.maxSeventhChords;
 
     tonality                    = s.tonality;
+    lean                        = s.lean;
     chords                      .update(home, s.chords);
     states                      .update(home, s.states);
     qualities                   .update(home, s.qualities);
@@ -91,6 +97,24 @@ ChordProgression::ChordProgression(Home home, ChordProgression &s){
     hasSeventh                  .update(home, s.hasSeventh);
 }
 
+/**
+ * Computes the values of an auxiliary array on a solution, from the assigned degree, state and quality of each chord.
+ * It works in both modes, and is the only way to get these values in lean mode.
+ * @param value the value of a chord (e.g. chord_bass_degree, see ChordValue)
+ * @return the value of each chord of the progression
+ * @throws std::runtime_error if a chord is not assigned
+ */
+vector<int> ChordProgression::values(const ChordValue value) const {
+    vector<int> result;
+    result.reserve(duration);
+    for (int i = 0; i < duration; i++) {
+        if (!chords[i].assigned() || !states[i].assigned() || !qualities[i].assigned())
+            throw std::runtime_error("The auxiliary values can only be computed on a solution");
+        result.push_back(value(chords[i].val(), states[i].val(), qualities[i].val()));
+    }
+    return result;
+}
+
 /**
  * Returns a string with each of the object's field values as integers. For debugging
  * @brief toString
@@ -116,16 +140,23 @@ string ChordProgression::toString() const{
     txt += "Chords:\t\t\t"                          + intVarArray_to_string(chords)         + "\n";
     txt += "States:\t\t\t"                          + intVarArray_to_string(states)         + "\n";
     txt += "Qualities:\t\t"                         + intVarArray_to_string(qualities)      + "\n";
-    txt += "Qualities (no seventh):\t"           + intVarArray_to_string(qualitiesWithoutSeventh) + "\n";
-    txt += "Bass degrees:\t\t"                      + intVarArray_to_string(bassDegrees)    + "\n";
+    /// in lean mode, the auxiliary arrays are computed from the solution, if the progression is solved
+    const bool solved = chords.assigned() && states.assigned() && qualities.assigned();
+    const auto auxiliary = [this, solved](const IntVarArray& vars, const ChordValue value) {
+        if (!lean)
+            return intVarArray_to_string(vars);
+        return solved ? int_vector_to_string(values(value)) : string("?");
+    };
+    txt += "Qualities (no seventh):\t"           + auxiliary(qualitiesWithoutSeventh, chord_quality_without_seventh) + "\n";
+    txt += "Bass degrees:\t\t"                      + auxiliary(bassDegrees, chord_bass_degree)    + "\n";
     txt += "Root notes:\t\t"                        + intVarArray_to_string(rootNotes)      + "\n";
-    txt += "Chromatic chords:\t"                    + intVarArray_to_string(isChromatic)    + "\n";
-    txt += "Seventh chords:\t\t"                    + intVarArray_to_string(hasSeventh)     + "\n";
+    txt += "Chromatic chords:\t"                    + auxiliary(isChromatic, chord_is_chromatic)    + "\n";
+    txt += "Seventh chords:\t\t"                    + auxiliary(hasSeventh, chord_has_seventh)     + "\n";
 
-    txt += "Roots:\t\t\t"                           + intVarArray_to_string(roots)          + "\n";
-    txt += "Thirds:\t\t\t"                          + intVarArray_to_string(thirds)         + "\n";
-    txt += "Fifths:\t\t\t"                          + intVarArray_to_string(fifths)         + "\n";
-    txt += "Sevenths:\t\t"                        + intVarArray_to_string(sevenths)       + "\n";
+    txt += "Roots:\t\t\t"                           + auxiliary(roots, chord_root)          + "\n";
+    txt += "Thirds:\t\t\t"                          + auxiliary(thirds, chord_third)         + "\n";
+    txt += "Fifths:\t\t\t"                          + auxiliary(fifths, chord_fifth)         + "\n";
+    txt += "Sevenths:\t\t"                        + auxiliary(sevenths, chord_seventh)       + "\n";
     return txt;
 }
 
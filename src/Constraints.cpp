@@ -3,6 +3,7 @@
 //
 
 #include "../headers/Constraints.hpp"
+#include "../headers/TonalityRegistry.hpp"
 
 /***********************************************************************************************************************
  *                                        Linker functions                                                             *
@@ -19,14 +20,9 @@
  * @param chords the array of chord degrees
  */
 void link_chords_to_qualities(const Home &home, const int size, const Tonality *tonality, IntVarArray qualities, IntVarArray chords){
-    for (int i = 0; i < size; i++){
-        if(tonality->get_mode() == MAJOR_MODE){
-            element(home, majorDegreeQualities, expr(home, chords[i] * nSupportedQualities + qualities[i]), 1);
-        }
-        else if(tonality->get_mode() == MINOR_MODE){
-            element(home, minorDegreeQualities, expr(home, chords[i] * nSupportedQualities + qualities[i]), 1);
-        }
-    }
+    const IntArgs& degreeQualities = *TonalityRegistry::get_tables(tonality).degreeQualities;
+    for (int i = 0; i < size; i++)
+        element(home, degreeQualities, expr(home, chords[i] * nSupportedQualities + qualities[i]), 1);
 }
 
 /**
@@ -66,13 +62,10 @@ void link_states_to_qualities(const Home &home, const int size, IntVarArray stat
  * @param rootNotes the slice of the rootNote array corresponding to this tonality
  * @param chords the array of chord degrees
  */
-void link_root_notes_to_degrees(const Home &home, const int size, Tonality *tonality, IntVarArray rootNotes, IntVarArray chords) {
-    vector<int> notes;
-    for (int i = FIRST_DEGREE; i <= AUGMENTED_SIXTH; i++)
-        notes.push_back(tonality->get_degree_note(i));
-    const IntArgs tonality_notes(notes);
+void link_root_notes_to_degrees(const Home &home, const int size, const Tonality *tonality, IntVarArray rootNotes, IntVarArray chords) {
+    const IntArgs& degreeNotes = TonalityRegistry::get_tables(tonality).degreeNotes;
     for (int i = 0; i < size; i++)
-        element(home, tonality_notes, chords[i], rootNotes[i]);
+        element(home, degreeNotes, chords[i], rootNotes[i]);
 }
 
 /**
@@ -169,14 +162,237 @@ void seventh_chords(const Home &home, const int size, IntVarArray qualities, Int
  * @param qualityWithoutSeventh the array of chord qualities without the seventh
  */
 void link_qualities_to_3note_version(const Home &home, int size, IntVarArray qualities, IntVarArray qualityWithoutSeventh) {
-    const IntArgs qualities_to_simple_version = {
-            ///   Major        Minor        Diminished        Augmented    Dominant7
-            MAJOR_CHORD, MINOR_CHORD, DIMINISHED_CHORD, AUGMENTED_CHORD, MAJOR_CHORD,
-            ///  Major7       Minor7       Diminished7    Half diminished,      MinorMajor,           Augmented sixth
-            MAJOR_CHORD, MINOR_CHORD, DIMINISHED_CHORD,  DIMINISHED_CHORD,     MINOR_CHORD,           AUGMENTED_CHORD
-    };
     for (int i = 0; i < size; i++) {
-        element(home, qualities_to_simple_version, qualities[i], qualityWithoutSeventh[i]);
+        element(home, simpleQualities, qualities[i], qualityWithoutSeventh[i]);
+    }
+}
+
+/***********************************************************************************************************************
+ *                                        Table model                                                                  *
+ ***********************************************************************************************************************/
+
+/**
+ * Whether a chord respects all the linker functions and the rules involving only one chord (flat_II_cst,
+ * chord_states_and_qualities, five_of_seven and diminished_seventh_dominant_chords).
+ * @param tonality the tonality of the chord
+ * @param degree the degree of the chord
+ * @param state the state of the chord
+ * @param quality the quality of the chord
+ * @return true if the chord is legal in the tonality
+ */
+bool is_legal_chord(const Tonality *tonality, const int degree, const int state, const int quality) {
+    /// five_of_seven: V/VII can only be used in minor mode
+    if (tonality->get_mode() == MAJOR_MODE && degree == FIVE_OF_SEVEN)
+        return false;
+    /// link_chords_to_states
+    if (degreeStates[degree * nSupportedStates + state] != 1)
+        return false;
+    /// flat_II_cst
+    if (degree == FLAT_TWO && state != FIRST_INVERSION)
+        return false;
+    /// link_chords_to_qualities
+    const IntArgs& degreeQualities = tonality->get_mode() == MAJOR_MODE ? majorDegreeQualities : minorDegreeQualities;
+    if (degreeQualities[degree * nSupportedQualities + quality] != 1)
+        return false;
+    /// seventh_chords, link_states_to_qualities and chord_states_and_qualities
+    if (quality < DOMINANT_SEVENTH_CHORD && state >= THIRD_INVERSION)
+        return false;
+    if (quality < MINOR_NINTH_DOMINANT_CHORD && state >= FOURTH_INVERSION)
+        return false;
+    /// diminished_seventh_dominant_chords
+    if (quality == DIMINISHED_SEVENTH_CHORD && degree != SEVENTH_DEGREE && state != FIRST_INVERSION)
+        return false;
+    return true;
+}
+
+/**
+ * Whether two successive legal chords respect the rules of tonal_progression involving two chords (chord_transitions,
+ * fifth_degree_appogiatura, the first rule of successive_chords_with_same_degree and the rules of voice_leading_rules).
+ * The repetition of a degree more than twice involves three chords and is not checked.
+ * @param degree the degree of the first chord
+ * @param state the state of the first chord
+ * @param quality the quality of the first chord
+ * @param nextDegree the degree of the second chord
+ * @param nextState the state of the second chord
+ * @param nextQuality the quality of the second chord
+ * @return true if the second chord can follow the first one
+ */
+bool is_legal_succession(const int degree, const int state, const int quality, const int nextDegree, const int nextState,
+                         const int nextQuality) {
+    /// chord_transitions
+    if (tonalTransitionsMatrix[degree * nSupportedChords + nextDegree] != 1)
+        return false;
+    /// fifth_degree_appogiatura
+    if (degree == FIFTH_DEGREE_APPOGIATURA &&
+        (nextState != FUNDAMENTAL_STATE || (nextQuality != MAJOR_CHORD && nextQuality != DOMINANT_SEVENTH_CHORD)))
+        return false;
+    /// successive_chords_with_same_degree
+    if (degree == nextDegree && state == nextState && quality == nextQuality)
+        return false;
+    /// tritone_resolutions, seventh_chords_preparation and diminished_seventh_dominant_chords
+    return is_legal_voice_leading(degree, state, quality, nextDegree, nextState, nextQuality);
+}
+
+/**
+ * Computes the chord table for a tonality. Each combination of degree, state and quality is checked against the rules
+ * involving a single chord (see is_legal_chord), and the values of the auxiliary variables are deduced from the music
+ * theory matrices.
+ * This is called once per tonality by the TonalityRegistry, use chord_table to get the shared table.
+ * @param tonality the tonality of the progression
+ * @param lean if true, the tuples only contain the columns of LeanChordTableColumn
+ * @return the finalized table of legal tuples for a chord in this tonality
+ */
+TupleSet build_chord_table(Tonality *tonality, const bool lean) {
+    TupleSet table(lean ? static_cast<int>(LEAN_CHORD_TABLE_ARITY) : static_cast<int>(CHORD_TABLE_ARITY));
+    for (int degree = FIRST_DEGREE; degree <= AUGMENTED_SIXTH; degree++) {
+        for (int state = FUNDAMENTAL_STATE; state <= FOURTH_INVERSION; state++) {
+            for (int quality = MAJOR_CHORD; quality <= MINOR_NINTH_DOMINANT_CHORD; quality++) {
+                if (!is_legal_chord(tonality, degree, state, quality))
+                    continue;
+                const int hasSeventh = quality >= DOMINANT_SEVENTH_CHORD ? 1 : 0;
+                /// chromatic_chords: the secondary dominants, bII, 6te_a and the diminished seventh V are chromatic
+                const int isChromatic = degree >= FIVE_OF_TWO ||
+                                        (degree == FIFTH_DEGREE && quality == DIMINISHED_SEVENTH_CHORD) ? 1 : 0;
+
+                if (lean) {
+                    IntArgs tuple(LEAN_CHORD_TABLE_ARITY);
+                    tuple[LEAN_TABLE_DEGREE]    = degree;
+                    tuple[LEAN_TABLE_STATE]     = state;
+                    tuple[LEAN_TABLE_QUALITY]   = quality;
+                    tuple[LEAN_TABLE_ROOT_NOTE] = tonality->get_degree_note(degree);
+                    table.add(tuple);
+                    continue;
+                }
+                IntArgs tuple(CHORD_TABLE_ARITY);
+                tuple[TABLE_DEGREE]         = degree;
+                tuple[TABLE_STATE]          = state;
+                tuple[TABLE_QUALITY]        = quality;
+                tuple[TABLE_BASS]           = bassBasedOnDegreeAndState[degree * nSupportedStates + state];
+                tuple[TABLE_ROOT]           = bassBasedOnDegreeAndState[degree * nSupportedStates + FUNDAMENTAL_STATE];
+                tuple[TABLE_THIRD]          = bassBasedOnDegreeAndState[degree * nSupportedStates + FIRST_INVERSION];
+                tuple[TABLE_FIFTH]          = bassBasedOnDegreeAndState[degree * nSupportedStates + SECOND_INVERSION];
+                tuple[TABLE_SEVENTH]        = bassBasedOnDegreeAndState[degree * nSupportedStates + THIRD_INVERSION];
+                tuple[TABLE_ROOT_NOTE]      = tonality->get_degree_note(degree);
+                tuple[TABLE_IS_CHROMATIC]   = isChromatic;
+                tuple[TABLE_HAS_SEVENTH]    = hasSeventh;
+                table.add(tuple);
+            }
+        }
+    }
+    table.finalize();
+    return table;
+}
+
+/**
+ * Returns the table of every legal combination of the variables describing a single chord in the given tonality, as
+ * tuples (degree, state, quality, bass, root, third, fifth, seventh, rootNote, isChromatic, hasSeventh). A tuple is
+ * legal if it respects all the linker functions above as well as the rules involving only one chord (flat_II_cst,
+ * chord_states_and_qualities, five_of_seven and diminished_seventh_dominant_chords).
+ * The table is precomputed by the TonalityRegistry and shared by all the progressions in the tonality.
+ * @param tonality the tonality of the progression
+ * @return the table of legal tuples for a chord in this tonality
+ */
+const TupleSet& chord_table(const Tonality *tonality) {
+    return TonalityRegistry::get_tables(tonality).chordTable;
+}
+
+/**
+ * Returns the chord table of the tonality projected on the degree, state, quality and root note of the chord, for the
+ * lean model that has no auxiliary variables.
+ * @param tonality the tonality of the progression
+ * @return the table of legal tuples (degree, state, quality, rootNote) for a chord in this tonality
+ */
+const TupleSet& lean_chord_table(const Tonality *tonality) {
+    return TonalityRegistry::get_tables(tonality).leanChordTable;
+}
+
+/**
+ * Links all the variables describing each chord with a single extensional constraint on the chord table of the tonality.
+ * This replaces the linker functions and the rules that involve only one chord, without the auxiliary variables that
+ * their decomposition creates. The number of chromatic and seventh chords is constrained as in chromatic_chords and
+ * seventh_chords.
+ * formula: (chords[i], states[i], qualities[i], ..., hasSeventh[i]) in chord_table(tonality)
+ * @param home the problem space
+ * @param size the number of chords in the progression
+ * @param tonality the tonality of the progression
+ * @param chords the array of chord degrees
+ * @param states the array of chord states
+ * @param qualities the array of chord qualities
+ * @param bassDegrees the array of bass degrees
+ * @param roots the array of root notes
+ * @param thirds the array of third notes
+ * @param fifths the array of fifth notes
+ * @param sevenths the array of seventh notes
+ * @param rootNotes the slice of the rootNote array corresponding to this tonality
+ * @param isChromatic the array of chromatic chords
+ * @param hasSeventh the array of seventh chords
+ * @param minChromaticChords the min number of chromatic chords we want
+ * @param maxChromaticChords the max number of chromatic chords we want
+ * @param minSeventhChords the min number of seventh chords we want
+ * @param maxSeventhChords the max number of seventh chords we want
+ */
+void link_chords_with_table(const Home &home, const int size, Tonality *tonality, IntVarArray chords, IntVarArray states,
+                            IntVarArray qualities, IntVarArray bassDegrees, IntVarArray roots, IntVarArray thirds,
+                            IntVarArray fifths, IntVarArray sevenths, IntVarArray rootNotes, IntVarArray isChromatic,
+                            IntVarArray hasSeventh, const int minChromaticChords, const int maxChromaticChords,
+                            const int minSeventhChords, const int maxSeventhChords) {
+    const TupleSet& table = chord_table(tonality);
+    for (int i = 0; i < size; i++) {
+        IntVarArgs chord;
+        chord << chords[i] << states[i] << qualities[i] << bassDegrees[i] << roots[i] << thirds[i] << fifths[i]
+              << sevenths[i] << rootNotes[i] << isChromatic[i] << hasSeventh[i];
+        extensional(home, chord, table);
+    }
+    ///count the number of chromatic and seventh chords
+    rel(home, sum(isChromatic) <= maxChromaticChords);
+    rel(home, sum(isChromatic) >= minChromaticChords);
+    rel(home, sum(hasSeventh) <= maxSeventhChords);
+    rel(home, sum(hasSeventh) >= minSeventhChords);
+}
+
+/**
+ * Links the degree, state, quality and root note of each chord with an extensional constraint on the lean chord table.
+ * The auxiliary variables are not created: the number of chromatic and seventh chords is only counted with temporary
+ * Boolean variables when the bounds can actually remove solutions.
+ * formula: (chords[i], states[i], qualities[i], rootNotes[i]) in lean_chord_table(tonality)
+ * @param home the problem space
+ * @param size the number of chords in the progression
+ * @param tonality the tonality of the progression
+ * @param chords the array of chord degrees
+ * @param states the array of chord states
+ * @param qualities the array of chord qualities
+ * @param rootNotes the slice of the rootNote array corresponding to this tonality
+ * @param minChromaticChords the min number of chromatic chords we want
+ * @param maxChromaticChords the max number of chromatic chords we want
+ * @param minSeventhChords the min number of seventh chords we want
+ * @param maxSeventhChords the max number of seventh chords we want
+ */
+void link_chords_with_lean_table(Home home, const int size, Tonality *tonality, IntVarArray chords,
+                                 IntVarArray states, IntVarArray qualities, IntVarArray rootNotes,
+                                 const int minChromaticChords, const int maxChromaticChords, const int minSeventhChords,
+                                 const int maxSeventhChords) {
+    const TupleSet& table = lean_chord_table(tonality);
+    for (int i = 0; i < size; i++) {
+        IntVarArgs chord;
+        chord << chords[i] << states[i] << qualities[i] << rootNotes[i];
+        extensional(home, chord, table);
+    }
+    ///count the number of chromatic chords, only if the bounds are not trivial
+    if (minChromaticChords > 0 || maxChromaticChords < size) {
+        BoolVarArgs isChromatic(home, size, 0, 1);
+        for (int i = 0; i < size; i++)
+            rel(home, isChromatic[i], BOT_EQV, expr(home, chords[i] >= FIVE_OF_TWO ||
+                (chords[i] == FIFTH_DEGREE && qualities[i] == DIMINISHED_SEVENTH_CHORD)), true);
+        rel(home, sum(isChromatic) <= maxChromaticChords);
+        rel(home, sum(isChromatic) >= minChromaticChords);
+    }
+    ///count the number of seventh chords, only if the bounds are not trivial
+    if (minSeventhChords > 0 || maxSeventhChords < size) {
+        BoolVarArgs hasSeventh(home, size, 0, 1);
+        for (int i = 0; i < size; i++)
+            rel(home, hasSeventh[i], BOT_EQV, expr(home, qualities[i] >= DOMINANT_SEVENTH_CHORD), true);
+        rel(home, sum(hasSeventh) <= maxSeventhChords);
+        rel(home, sum(hasSeventh) >= minSeventhChords);
     }
 }
 
@@ -197,6 +413,76 @@ void chord_transitions(const Home &home, const int size, IntVarArray chords) {
         element(home, tonalTransitions, expr(home, chords[i] * nSupportedChords + chords[i + 1]), 1);
 }
 
+/**
+ * Builds the automaton recognising the valid sequences of chord degrees in a mode.
+ * State 0 is the initial state, state 1 + c means that the last chord is c and is not a repetition, and state
+ * 1 + nSupportedChords + c means that the last two chords are c. Every state except the initial one is final.
+ * This is called by the TonalityRegistry, use chord_transitions_automaton to get the shared automaton.
+ * @param mode the mode of the tonality
+ * @return the automaton for this mode
+ */
+DFA build_chord_transitions_automaton(const int mode) {
+    const int initial = 0;
+    auto once = [](const int chord) { return 1 + chord; };
+    auto twice = [](const int chord) { return 1 + nSupportedChords + chord; };
+    auto allowed = [mode](const int chord) { return mode != MAJOR_MODE || chord != FIVE_OF_SEVEN; };
+
+    vector<DFA::Transition> transitions;
+    auto add = [&transitions](const int from, const int symbol, const int to) {
+        DFA::Transition t;
+        t.i_state = from;   t.symbol = symbol;      t.o_state = to;
+        transitions.push_back(t);
+    };
+    for (int next = FIRST_DEGREE; next <= AUGMENTED_SIXTH; next++) {
+        if (!allowed(next))
+            continue;
+        add(initial, next, once(next));
+        for (int last = FIRST_DEGREE; last <= AUGMENTED_SIXTH; last++) {
+            if (!allowed(last) || tonalTransitions[last * nSupportedChords + next] != 1)
+                continue;
+            if (next == last)           /// the degree is repeated once, it cannot be repeated again
+                add(once(last), next, twice(last));
+            else {
+                add(once(last), next, once(next));
+                add(twice(last), next, once(next));
+            }
+        }
+    }
+    add(-1, 0, 0);          /// end of the transitions
+
+    vector<int> finals;
+    for (int state = 1; state <= 2 * nSupportedChords; state++)
+        finals.push_back(state);
+    finals.push_back(-1);   /// end of the final states
+
+    return DFA(initial, transitions.data(), finals.data());
+}
+
+/**
+ * Returns the automaton recognising the valid sequences of chord degrees in the given mode. It accepts the words where
+ * each transition is possible (tonalTransitions), where the same degree does not happen more than twice successively,
+ * and where V/VII is only used in minor mode. The fifth degree appogiatura can only be followed by V in tonalTransitions,
+ * so the part of fifth_degree_appogiatura on the degrees is also covered. The automaton is precomputed by the
+ * TonalityRegistry.
+ * @param tonality the tonality of the progression
+ * @return the automaton for the mode of the tonality
+ */
+const DFA& chord_transitions_automaton(const Tonality *tonality) {
+    return TonalityRegistry::get_tables(tonality).transitionsAutomaton;
+}
+
+/**
+ * Enforces that the chord progression is valid with a single regular constraint on the whole chords array, using the
+ * automaton from chord_transitions_automaton. It replaces chord_transitions, five_of_seven and the repetition rule of
+ * successive_chords_with_same_degree, and propagates along the whole sequence instead of pairwise.
+ * @param home the problem space
+ * @param chords the array of chord degrees
+ * @param tonality the tonality of the progression
+ */
+void regular_chord_transitions(const Home &home, const IntVarArray &chords, const Tonality *tonality) {
+    extensional(home, chords, chord_transitions_automaton(tonality));
+}
+
 /**
  * Force the last chord to be diatonic and not the seventh chord,
  * The chord progression cannot end on something other than a diatonic chord (also not seventh degree)
@@ -250,13 +536,16 @@ void flat_II_cst(const Home &home, int size, IntVarArray states, IntVarArray cho
  * @param states the array of chord states
  * @param qualities the array of chord qualities
  * @param chords the array of chord degrees
+ * @param degreeRepetitions whether to post the second rule (it is already in the automaton of regular_chord_transitions)
  */
 void successive_chords_with_same_degree(const Home &home, int size, IntVarArray states, IntVarArray qualities,
-                                        IntVarArray chords) {
+                                        IntVarArray chords, const bool degreeRepetitions) {
     ///If two successive chords are the same degree, they cannot have the same state or the same quality
     for (int i = 0; i < size - 1; i++)
         rel(home, expr(home, chords[i] == chords[i + 1]), BOT_IMP,
             expr(home, states[i] != states[i + 1] || qualities[i] != qualities[i + 1]), true);
+    if (!degreeRepetitions)
+        return;
     ///The same degree cannot happen more than twice successively
     for(int i = 0; i < size-2; i++)
         rel(home, expr(home, chords[i] == chords[i+1]), BOT_IMP,
@@ -379,24 +668,28 @@ void diminished_seventh_dominant_chords(const Home &home, int size, IntVarArray
  * @param type the type of cadence
  * @param states the array of chord states
  * @param chords the array of chord degrees
- * @param hasSeventh the array of seventh chords
+ * @param qualities the array of chord qualities
  */
-void cadence(const Home &home, int position, int type, IntVarArray states, IntVarArray chords, IntVarArray hasSeventh) {
+void cadence(const Home &home, int position, int type, IntVarArray states, IntVarArray chords, IntVarArray qualities) {
     switch (type){
         case PERFECT_CADENCE:        /// V7+/9-I5. The dominant chord can have a 7th but it is not mandatory, the I chord cannot
             rel(home, chords[position] == FIFTH_DEGREE && states[position] == FUNDAMENTAL_STATE);
-            rel(home, chords[position + 1] == FIRST_DEGREE && states[position + 1] == FUNDAMENTAL_STATE && hasSeventh[position + 1] == 0);
+            rel(home, chords[position + 1] == FIRST_DEGREE && states[position + 1] == FUNDAMENTAL_STATE &&
+                  qualities[position + 1] < DOMINANT_SEVENTH_CHORD);
             break;
         case PLAGAL_CADENCE:         /// IV-I without a seventh on both chords
-            rel(home, chords[position] == FOURTH_DEGREE && states[position] == FUNDAMENTAL_STATE && hasSeventh[position] == 0);
-            rel(home, chords[position + 1] == FIRST_DEGREE && states[position + 1] == FUNDAMENTAL_STATE && hasSeventh[position + 1] == 0);
+            rel(home, chords[position] == FOURTH_DEGREE && states[position] == FUNDAMENTAL_STATE &&
+                  qualities[position] < DOMINANT_SEVENTH_CHORD);
+            rel(home, chords[position + 1] == FIRST_DEGREE && states[position + 1] == FUNDAMENTAL_STATE &&
+                  qualities[position + 1] < DOMINANT_SEVENTH_CHORD);
             break;
         case HALF_CADENCE:           /// V5/7+. The dominant chord can have a 7th but it is not mandatory
             rel(home, chords[position] == FIFTH_DEGREE && states[position] == FUNDAMENTAL_STATE);
             break;
         case DECEPTIVE_CADENCE:      /// V-VI. The dominant chord can have a 7th but it is not mandatory, the VI chord cannot
             rel(home, chords[position] == FIFTH_DEGREE && states[position] == FUNDAMENTAL_STATE);
-            rel(home, chords[position + 1] == SIXTH_DEGREE && states[position + 1] == FUNDAMENTAL_STATE && hasSeventh[position + 1] == 0);
+            rel(home, chords[position + 1] == SIXTH_DEGREE && states[position + 1] == FUNDAMENTAL_STATE &&
+                  qualities[position + 1] < DOMINANT_SEVENTH_CHORD);
             break;
         default:                     /// Ignore unknown types
             break;
@@ -0,0 +1,176 @@
+//
+// Created on 16/10/2026.
+//
+
+#include "../headers/DecomposedSolver.hpp"
+
+/**
+ * Splits a piece into clusters at the modulations whose tonalities do not share any chord. The clusters only interact
+ * through the constraints of these modulations, which apply to the chords around the cut.
+ * @param params the parameters of the piece
+ * @return the clusters, in the order of the piece
+ */
+vector<PieceCluster> find_clusters(const TonalPieceParameters& params) {
+    vector<PieceCluster> clusters;
+    PieceCluster cluster{0, 0, 0, 0};
+    for (int i = 0; i < params.get_nProgressions() - 1; i++) {
+        const int end = params.get_progressionStart(i) + params.get_progressionDuration(i) - 1;
+        if (params.get_progressionStart(i + 1) <= end)
+            continue;   /// the next tonality starts on a chord of this one (pivot chord modulation)
+        cluster.lastProgression = i;
+        cluster.end = end;
+        clusters.push_back(cluster);
+        cluster = PieceCluster{i + 1, i + 1, params.get_progressionStart(i + 1), 0};
+    }
+    cluster.lastProgression = params.get_nProgressions() - 1;
+    cluster.end = params.get_size() - 1;
+    clusters.push_back(cluster);
+    return clusters;
+}
+
+/**
+ * Creates the parameters of a cluster as a piece of its own, starting at position 0. The model options and the soft
+ * rules of the piece are copied.
+ * @param params the parameters of the piece
+ * @param cluster a cluster of the piece
+ * @return the parameters of the cluster
+ */
+std::unique_ptr<TonalPieceParameters> cluster_parameters(const TonalPieceParameters& params,
+                                                         const PieceCluster& cluster) {
+    vector<Tonality*> tonalities;
+    vector<int> modulationTypes, modulationStarts, modulationEnds;
+    for (int i = cluster.firstProgression; i <= cluster.lastProgression; i++) {
+        tonalities.push_back(params.get_tonality(i));
+        if (i == cluster.lastProgression)
+            break;
+        modulationTypes .push_back(params.get_modulationType(i));
+        modulationStarts.push_back(params.get_modulationStart(i) - cluster.start);
+        modulationEnds  .push_back(params.get_modulationEnd(i) - cluster.start);
+    }
+    auto sub = std::make_unique<TonalPieceParameters>(cluster.end - cluster.start + 1,
+                                                      static_cast<int>(tonalities.size()), tonalities,
+                                                      modulationTypes, modulationStarts, modulationEnds);
+    sub->set_modelOptions(params.get_modelOptions());
+    for (const auto& rule : params.get_softRules())
+        sub->add_softRule(rule);
+
+    /// the progressions of the cluster must be the same as in the piece, so that the constraints are the same
+    for (int i = cluster.firstProgression; i <= cluster.lastProgression; i++) {
+        const int k = i - cluster.firstProgression;
+        if (sub->get_progressionStart(k) + cluster.start != params.get_progressionStart(i) ||
+            sub->get_progressionDuration(k) != params.get_progressionDuration(i))
+            throw std::logic_error("The progressions of a cluster do not match the ones of the piece");
+    }
+    return sub;
+}
+
+/**
+ * Solves a piece by parts. The piece is split into clusters (see find_clusters), which are solved in parallel with
+ * solve_harmoniser_batch. The solutions of the clusters are then joined with a search on the whole piece in which only
+ * the chords around the cuts are free, so that the constraints of the modulations at the cuts can be satisfied. If the
+ * join fails, the windows around the cuts are doubled until they cover the whole piece. The solution is the same as
+ * solve_harmoniser would give when the piece has a single cluster.
+ * The time limit of the options is shared by all the phases: the clusters and each join get the time left until the
+ * end of the limit. The report tells whether the search was stopped by the limits, in which case nullptr does not mean
+ * that the piece has no solution. Its statistics add up the ones of the joins.
+ * @param params the parameters of the piece, they must outlive the solution
+ * @param report the report of the search, filled by the function
+ * @param workers the number of worker threads for the clusters, 0 for one per core
+ * @param window the number of chords freed on each side of a cut for the first join
+ * @param options the search options, the portfolio and optimisation modes are not supported
+ * @return the solution, or nullptr if no solution was found
+ */
+TonalPiece* solve_harmoniser_decomposed(TonalPieceParameters* params, SearchReport& report, const unsigned int workers,
+                                        int window, const HarmoniserOptions& options) {
+    if (options.portfolio)
+        throw std::invalid_argument("The decomposed solver does not support the portfolio mode");
+    if (options.optimise)
+        throw std::invalid_argument("The decomposed solver cannot optimise the piece, the clusters are optimised alone");
+    const vector<PieceCluster> clusters = find_clusters(*params);
+    if (clusters.size() == 1)       /// the branching is posted by solve_harmoniser with the seed of the options
+        return solve_harmoniser(new TonalPiece(params, false), report, false, options);
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = options.timeLimit > 0 ? start + std::chrono::milliseconds(options.timeLimit)
+                                                : std::chrono::steady_clock::time_point::max();
+    report = SearchReport();
+    const auto finish = [&](TonalPiece* sol, const bool stopped) {
+        report.stopped   = stopped;
+        report.time      = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        report.solutions = sol != nullptr ? 1 : 0;
+        return sol;
+    };
+
+    /// solve the clusters in parallel
+    vector<std::unique_ptr<TonalPieceParameters>> subParams;
+    vector<TonalPieceParameters*> jobs;
+    for (const auto& c : clusters) {
+        subParams.push_back(cluster_parameters(*params, c));
+        jobs.push_back(subParams.back().get());
+    }
+    const vector<BatchResult> results = solve_harmoniser_batch(jobs, workers, options, deadline);
+
+    /// a cluster has less constraints than the piece, so the piece has no solution if one of them has none. A cluster
+    /// that was stopped says nothing about the piece.
+    vector<vector<int>> degrees;
+    vector<int> states(params->get_size()), qualities(params->get_size());
+    bool stopped = false;
+    for (size_t c = 0; c < clusters.size(); c++) {
+        if (!results[c].error.empty())
+            throw std::runtime_error(results[c].error);
+        if (!results[c].solved) {
+            if (!results[c].report.stopped)
+                return finish(nullptr, false);
+            stopped = true;
+            continue;
+        }
+        const HarmoniserSolution& sol = results[c].solution;
+        degrees.insert(degrees.end(), sol.degrees.begin(), sol.degrees.end());
+        for (size_t i = 0; i < sol.states.size(); i++) {
+            states[clusters[c].start + i]       = sol.states[i];
+            qualities[clusters[c].start + i]    = sol.qualities[i];
+        }
+    }
+    if (stopped)
+        return finish(nullptr, true);
+
+    /// join the clusters, with growing windows around the cuts, until the end of the time limit
+    window = std::max(1, window);
+    while (true) {
+        HarmoniserOptions joinOptions = options;
+        if (options.timeLimit > 0) {
+            joinOptions.timeLimit = time_left(deadline);
+            if (joinOptions.timeLimit == 0)
+                return finish(nullptr, true);
+        }
+        vector<std::pair<int, int>> windows;
+        for (size_t c = 1; c < clusters.size(); c++)
+            windows.emplace_back(std::max(0, clusters[c].start - window),
+                                 std::min(params->get_size() - 1, clusters[c].start + window - 1));
+
+        const auto piece = new TonalPiece(params, false);
+        piece->fix(degrees, states, qualities, windows);
+        piece->set_seed(options.seed);
+        piece->post_branching(BRANCH_SIZE_RANDOM);
+        SearchReport join;
+        const auto sol = solve_harmoniser(piece, join, false, joinOptions);
+        report.statistics.node      += join.statistics.node;
+        report.statistics.fail      += join.statistics.fail;
+        report.statistics.propagate += join.statistics.propagate;
+        report.statistics.depth      = std::max(report.statistics.depth, join.statistics.depth);
+        report.clones               += join.clones;
+        report.processPeakRss        = join.processPeakRss;
+        if (sol != nullptr || join.stopped)
+            return finish(sol, join.stopped);
+        if (window >= params->get_size())
+            return finish(nullptr, false);
+        window *= 2;
+    }
+}
+
+/// see solve_harmoniser_decomposed(TonalPieceParameters*, SearchReport&, unsigned int, int, const HarmoniserOptions&)
+TonalPiece* solve_harmoniser_decomposed(TonalPieceParameters* params, const unsigned int workers, const int window,
+                                        const HarmoniserOptions& options) {
+    SearchReport report;
+    return solve_harmoniser_decomposed(params, report, workers, window, options);
+}
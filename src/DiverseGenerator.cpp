@@ -0,0 +1,133 @@
+//
+// Created on 16/10/2026.
+//
+
+#include "../headers/DiverseGenerator.hpp"
+#include "../headers/TemplatePool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <thread>
+#include <unordered_map>
+
+/**
+ * Returns a hash of the degrees, states and qualities of a solution, the values that make two harmonisations different
+ * @param solution a solution
+ * @return the hash of the solution
+ */
+size_t solution_hash(const HarmoniserSolution& solution) {
+    size_t h = 0;
+    const auto combine = [&h](const int value) {
+        h ^= std::hash<int>()(value) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    };
+    for (const auto& progression : solution.degrees) {
+        for (const int degree : progression)
+            combine(degree);
+        combine(-1);        /// separates the progressions
+    }
+    for (const int state : solution.states)
+        combine(state);
+    for (const int quality : solution.qualities)
+        combine(quality);
+    return h;
+}
+
+/**
+ * Generates distinct solutions of a piece with independent searches in parallel. Search k uses the seed options.seed + k
+ * for its random value selection, and its solution is kept if no kept solution has the same degrees, states and
+ * qualities (solution_hash is only used to find the kept solutions to compare with). The model of the piece is built
+ * and propagated once, every search starts from a clone of it (see TemplatePool). The generation stops once count
+ * distinct solutions are found, maxSearches searches are done or the time budget is spent: no search starts after the
+ * end of the budget, and each search gets at most the time left.
+ * @param params the parameters of the piece
+ * @param count the number of distinct solutions wanted
+ * @param workers the number of worker threads, 0 for one per core
+ * @param maxSearches the maximal number of searches, 0 for 4 * count
+ * @param budget the time limit of the whole generation in milliseconds, 0 for none
+ * @param options the search options of every search, the time and fail limits apply to each of them. The portfolio mode
+ * is not supported.
+ * @return the distinct solutions, in the order they were found
+ */
+vector<HarmoniserSolution> solve_harmoniser_diverse(TonalPieceParameters* params, const unsigned int count,
+                                                    unsigned int workers, unsigned long maxSearches,
+                                                    const unsigned int budget, const HarmoniserOptions& options) {
+    if (options.portfolio)
+        throw std::invalid_argument("Each search of the diverse generation runs one engine, the portfolio mode is not supported");
+    if (maxSearches == 0)
+        maxSearches = 4UL * count;
+    if (workers == 0)
+        workers = std::max(1U, std::thread::hardware_concurrency());
+    workers = static_cast<unsigned int>(std::min<unsigned long>(workers, std::max(1UL, maxSearches)));
+
+    TemplatePool pool(1);
+    std::mutex resultsMutex;
+    vector<HarmoniserSolution> results;
+    std::unordered_map<size_t, vector<size_t>> seen;     /// the indices of the kept solutions of each hash
+    std::atomic<unsigned long> next(0);
+    std::atomic<bool> done(count == 0);
+    std::exception_ptr error;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(budget);
+
+    /// the hashes of different solutions can collide, so the solutions with the same hash are compared
+    const auto is_new = [&](const HarmoniserSolution& solution, const vector<size_t>& sameHash) {
+        for (const size_t k : sameHash)
+            if (results[k].degrees == solution.degrees && results[k].states == solution.states &&
+                results[k].qualities == solution.qualities)
+                return false;
+        return true;
+    };
+
+    const auto work = [&]() {
+        for (unsigned long search = next++; search < maxSearches && !done; search = next++) {
+            /// no search starts after the end of the budget
+            const unsigned int left = budget > 0 ? time_left(deadline) : 0;
+            if (budget > 0 && left == 0) {
+                done = true;
+                return;
+            }
+            try {
+                const auto piece = pool.acquire(params);
+                if (piece == nullptr) {          /// the piece has no solution, no seed will find one
+                    done = true;
+                    return;
+                }
+                HarmoniserOptions searchOptions = options;
+                searchOptions.seed = options.seed + static_cast<unsigned int>(search);
+                if (budget > 0 && (options.timeLimit == 0 || left < options.timeLimit))
+                    searchOptions.timeLimit = left;
+                SearchReport report;
+                const auto sol = solve_harmoniser(piece, report, false, searchOptions);
+                if (sol == nullptr)
+                    continue;
+                HarmoniserSolution solution(*sol);
+                delete sol;
+
+                std::lock_guard<std::mutex> lock(resultsMutex);
+                vector<size_t>& sameHash = seen[solution_hash(solution)];
+                if (results.size() < count && is_new(solution, sameHash)) {
+                    sameHash.push_back(results.size());
+                    results.push_back(std::move(solution));
+                }
+                if (results.size() >= count)
+                    done = true;
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(resultsMutex);
+                if (error == nullptr)
+                    error = std::current_exception();
+                done = true;
+            }
+        }
+    };
+
+    vector<std::thread> threads;
+    threads.reserve(workers);
+    for (unsigned int i = 0; i < workers; i++)
+        threads.emplace_back(work);
+    for (auto& t : threads)
+        t.join();
+    if (error != nullptr)
+        std::rethrow_exception(error);
+    return results;
+}
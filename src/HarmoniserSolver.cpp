@@ -4,17 +4,124 @@
 
 #include "../headers/HarmoniserSolver.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <sys/resource.h>
+
 /**
- * Solves a harmonization problem for a given TonalPiece.
- * @param piece the TonalPiece to solve
- * @param print if true, prints the number of solutions and the last solution found
- * @return the last solution found, or nullptr if no solution was found
+ * Stops the search when the time limit or the fail limit of the options is reached.
  */
-TonalPiece* solve_harmoniser(TonalPiece* piece, const bool print) {
+class HarmoniserStop : public Search::Stop {
+private:
+    const std::chrono::steady_clock::time_point start;  /// the time at which the search started
+    const unsigned int timeLimit;                       /// the time limit in milliseconds, 0 for none
+    const unsigned long failLimit;                      /// the maximal number of failures, 0 for none
 
-    DFS<TonalPiece> engine(piece);
-    delete piece;
+public:
+    HarmoniserStop(const unsigned int timeLimit, const unsigned long failLimit) :
+        start(std::chrono::steady_clock::now()), timeLimit(timeLimit), failLimit(failLimit) {}
+
+    bool stop(const Search::Statistics& s, const Search::Options&) override {
+        if (failLimit > 0 && s.fail > failLimit)
+            return true;
+        return timeLimit > 0 && std::chrono::steady_clock::now() - start > std::chrono::milliseconds(timeLimit);
+    }
+};
+
+/**
+ * Creates the stop object for the limits of the options
+ * @param options the search options
+ * @return the stop object, or nullptr if there is no limit. It must outlive the engines, which do not own it.
+ */
+static std::unique_ptr<Search::Stop> make_stop(const HarmoniserOptions& options) {
+    if (options.timeLimit == 0 && options.failLimit == 0)
+        return nullptr;
+    return std::make_unique<HarmoniserStop>(options.timeLimit, options.failLimit);
+}
 
+/**
+ * Returns the peak resident memory of the process
+ * @return the peak resident memory in bytes
+ */
+static size_t process_peak_rss() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);            /// in bytes on macOS
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;     /// in kilobytes on Linux
+#endif
+}
+
+/**
+ * Creates the options common to every engine: the limits and the copy and recomputation distances. In automatic mode,
+ * the commit distance grows with the size of the piece: short pieces are copied at every node, which costs memory but
+ * no recomputation, and long pieces are copied less often to bound the memory used by the open nodes.
+ * @param options the search options
+ * @param size the number of chords in the piece
+ * @param stop the stop object of the limits, or nullptr
+ * @return the options of the engines
+ */
+static Search::Options engine_options(const HarmoniserOptions& options, const int size, Search::Stop* stop) {
+    Search::Options opts;
+    opts.stop = stop;
+    if (options.autoRecomputation) {
+        opts.c_d = std::clamp(size / 8, 1, 32);
+        opts.a_d = std::max(1U, opts.c_d / 4);
+    }
+    if (options.commitDistance > 0)
+        opts.c_d = options.commitDistance;
+    if (options.adaptiveDistance > 0)
+        opts.a_d = options.adaptiveDistance;
+    return opts;
+}
+
+/**
+ * Fills the report at the end of a search.
+ * @param engine the search engine
+ * @param n_sols the number of solutions found
+ * @param start the time at which the search started
+ * @param report the report to fill
+ */
+template<class Engine>
+static void report_search(const Engine& engine, const int n_sols,
+                          const std::chrono::high_resolution_clock::time_point start, SearchReport& report) {
+    const std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+    report.statistics   = engine.statistics();
+    report.stopped      = engine.stopped();
+    report.time         = duration.count();
+    report.solutions    = n_sols;
+    report.processPeakRss = process_peak_rss();
+}
+
+/**
+ * Prints the last solution found and the statistics of the search.
+ * @param last_sol the last solution found
+ * @param report the report of the search
+ */
+static void print_search(const TonalPiece* last_sol, const SearchReport& report) {
+    std::cout << "Number of solutions: " << report.solutions << std::endl <<
+        "Last solution found:\n" << last_sol->pretty() << std::endl;
+
+    std::cout << "time taken: " << report.time << " seconds and " << report.solutions << " solutions found.\n" << std::endl;
+
+    std::cout << statistics_to_string(report.statistics);
+    std::cout << "Clones: " << last_sol->get_clones() << ", bytes per clone: " << last_sol->clone_size() << std::endl;
+    std::cout << "Peak memory of the process: " << report.processPeakRss / 1024 << " kB, maximal depth: " << report.statistics.depth
+        << std::endl;
+}
+
+/**
+ * Looks for the first solution with the given engine, and prints the statistics of the search.
+ * @param engine a search engine on TonalPiece spaces
+ * @param print if true, prints the number of solutions and the last solution found
+ * @param report the report of the search, filled by the function
+ * @return the last solution found, or nullptr if no solution was found
+ */
+template<class Engine>
+static TonalPiece* first_solution(Engine& engine, const bool print, SearchReport& report) {
     int n_sols = 0;
     TonalPiece* last_sol = nullptr;
     const auto start = std::chrono::high_resolution_clock::now();     /// start time
@@ -24,17 +131,424 @@ TonalPiece* solve_harmoniser(TonalPiece* piece, const bool print) {
         if(n_sols >= 1) break;
         delete sol;
     }
+    report_search(engine, n_sols, start, report);
     if (n_sols == 0 || last_sol == nullptr) {
         if (print) std::cout << "No solution found." << std::endl;
         return nullptr;
     }
-    if (print) std::cout << "Number of solutions: " << n_sols << std::endl <<
-        "Last solution found:\n" << last_sol->pretty() << std::endl;
+    if (print) print_search(last_sol, report);
+    return last_sol;
+}
 
-    const auto end = std::chrono::high_resolution_clock::now();     /// start time
-    const std::chrono::duration<double> duration = end - start;
-    if (print) std::cout << "time taken: " << duration.count() << " seconds and " << n_sols << " solutions found.\n" << std::endl;
+/**
+ * Looks for the best solution with a branch and bound engine. Each solution returned by the engine is cheaper than the
+ * previous one, it is printed with its cost and passed to options.onImprovement before the search goes on.
+ * @param engine a branch and bound search engine on TonalPiece spaces
+ * @param print if true, prints the cost of each improving solution, the best solution and the statistics
+ * @param options the search options
+ * @param report the report of the search, filled by the function
+ * @return the best solution found, or nullptr if no solution was found
+ */
+template<class Engine>
+static TonalPiece* best_solution(Engine& engine, const bool print, const HarmoniserOptions& options,
+                                 SearchReport& report) {
+    int n_sols = 0;
+    TonalPiece* best_sol = nullptr;
+    const auto start = std::chrono::high_resolution_clock::now();     /// start time
+    while(TonalPiece* sol = engine.next()) {
+        n_sols += 1;
+        if (print) std::cout << "Solution " << n_sols << " with cost " << sol->getCost().val() << std::endl;
+        if (options.onImprovement) options.onImprovement(*sol);
+        delete best_sol;
+        best_sol = sol;
+    }
+    report_search(engine, n_sols, start, report);
+    if (best_sol == nullptr) {
+        if (print) std::cout << "No solution found." << std::endl;
+        return nullptr;
+    }
+    if (print) print_search(best_sol, report);
+    return best_sol;
+}
 
-    if (print) std::cout << statistics_to_string(engine.statistics());
-    return last_sol;
+/**
+ * Creates the cutoff sequence for the restarts
+ * @param options the search options
+ * @param size the number of chords in the piece, used when options.cutoffScale is 0
+ * @return the cutoff sequence, owned by the search engine it is given to
+ */
+static Search::Cutoff* make_cutoff(const HarmoniserOptions& options, const int size) {
+    const unsigned long scale = options.cutoffScale > 0 ? options.cutoffScale : static_cast<unsigned long>(size);
+    switch (options.cutoff) {
+        case LUBY_CUTOFF:
+            return Search::Cutoff::luby(scale);
+        case GEOMETRIC_CUTOFF:
+            return Search::Cutoff::geometric(scale, options.geometricBase);
+        case MERGED_CUTOFF:
+            return Search::Cutoff::merge(Search::Cutoff::linear(2 * scale),
+                                         Search::Cutoff::geometric(4 * scale, options.geometricBase));
+        default:
+            throw std::invalid_argument("Invalid restart cutoff");
+    }
+}
+
+/**
+ * Solves the piece with a portfolio of engines. Asset i branches with the strategy i % N_BRANCHING_STRATEGIES and the
+ * seed options.seed + i. The assets of every other group of N_BRANCHING_STRATEGIES restart with the cutoff sequence of
+ * the options, so that each strategy is tried with and without restarts.
+ * @param piece the TonalPiece to solve, without branching
+ * @param print if true, prints the number of solutions and the last solution found
+ * @param options the search options
+ * @param opts the options of the portfolio engine
+ * @param report the report of the search, filled by the function
+ * @return the first solution found, or nullptr if no solution was found
+ */
+static TonalPiece* solve_portfolio(TonalPiece* piece, const bool print, const HarmoniserOptions& options,
+                                   Search::Options opts, SearchReport& report) {
+    if (piece->has_branching()) {
+        delete piece;
+        throw std::invalid_argument("The piece must be created without branching for a portfolio search");
+    }
+    if (options.optimise) {
+        delete piece;
+        throw std::invalid_argument("The portfolio search only looks for a first solution");
+    }
+    const unsigned int assets = options.assets > 0 ? options.assets :
+                                std::max(1U, std::thread::hardware_concurrency());
+    piece->set_seed(options.seed);
+
+    SEBs sebs(static_cast<int>(assets));
+    for (unsigned int i = 0; i < assets; i++) {
+        Search::Options assetOptions = opts;
+        assetOptions.threads = 1;
+        if ((i / N_BRANCHING_STRATEGIES) % 2 == 0)
+            sebs[static_cast<int>(i)] = dfs<TonalPiece>(assetOptions);
+        else {
+            assetOptions.cutoff = make_cutoff(options, piece->getParameters()->get_size());
+            assetOptions.nogoods_limit = options.nogoodsLimit;
+            sebs[static_cast<int>(i)] = rbs<TonalPiece, DFS>(assetOptions);
+        }
+    }
+    opts.threads = assets;
+    opts.assets = assets;
+
+    PBS<TonalPiece> engine(piece, sebs, opts);
+    delete piece;
+    return first_solution(engine, print, report);
+}
+
+/**
+ * Runs the search of solve_harmoniser, with the engine chosen by the options
+ * @param piece the TonalPiece to solve
+ * @param report the report of the search, filled by the function
+ * @param print if true, prints the number of solutions and the last solution found
+ * @param options the search options
+ * @return the last solution found, or nullptr if no solution was found
+ */
+static TonalPiece* run_search(TonalPiece* piece, SearchReport& report, const bool print,
+                              const HarmoniserOptions& options) {
+    /// the stop object must outlive the engines, which do not own it
+    const std::unique_ptr<Search::Stop> stop = make_stop(options);
+    Search::Options opts = engine_options(options, piece->getParameters()->get_size(), stop.get());
+
+    if (options.portfolio)
+        return solve_portfolio(piece, print, options, opts, report);
+    if (!piece->has_branching()) {
+        piece->set_seed(options.seed);
+        piece->post_branching(BRANCH_SIZE_RANDOM);
+    }
+
+    if (options.lns) {
+        if (stop == nullptr) {
+            delete piece;
+            throw std::invalid_argument("The large neighbourhood search needs a time or fail limit");
+        }
+        piece->set_neighbourhood(options.lnsWindow);
+        opts.cutoff = Search::Cutoff::constant(options.lnsFailLimit);
+        opts.nogoods_limit = 0;     /// the nogoods of a neighbourhood do not hold in the rest of the search
+        RBS<TonalPiece, BAB> engine(piece, opts);
+        delete piece;
+        return best_solution(engine, print, options, report);
+    }
+
+    if (options.restarts) {
+        opts.cutoff = make_cutoff(options, piece->getParameters()->get_size());
+        opts.nogoods_limit = options.nogoodsLimit;
+        if (options.optimise) {
+            RBS<TonalPiece, BAB> engine(piece, opts);
+            delete piece;
+            return best_solution(engine, print, options, report);
+        }
+        RBS<TonalPiece, DFS> engine(piece, opts);
+        delete piece;
+        return first_solution(engine, print, report);
+    }
+
+    if (options.optimise) {
+        BAB<TonalPiece> engine(piece, opts);
+        delete piece;
+        return best_solution(engine, print, options, report);
+    }
+
+    DFS<TonalPiece> engine(piece, opts);
+    delete piece;
+    return first_solution(engine, print, report);
+}
+
+/**
+ * Solves a harmonization problem for a given TonalPiece.
+ * With restarts, the search restarts from the root each time the number of failures reaches the next value of the
+ * cutoff sequence, and the nogoods learnt from the previous restart are posted. Since the values of the chords are chosen
+ * at random, each restart explores a different part of the search tree.
+ * In optimisation mode, a branch and bound search minimises the cost of the soft rules of the piece (see SoftRule), and
+ * the best solution is returned once the search is complete.
+ * In large neighbourhood mode, the search restarts each time the fail limit is reached or a solution is found. After
+ * the first solution, only a window of the piece is relaxed around the incumbent at each restart, and a cheaper
+ * solution is looked for in this window until the time or fail limit is reached (see TonalPiece::relax). Without soft rules,
+ * the first solution is returned.
+ * In portfolio mode, the piece must be created without branching: each engine of the portfolio posts its own
+ * BranchingStrategy with its own seed, and half of them restart with the cutoff sequence. The first solution found by
+ * any engine is returned and the other engines are stopped.
+ * In the other modes, a piece created without branching gets the default branching with the seed of the options.
+ * @param piece the TonalPiece to solve
+ * @param print if true, prints the number of solutions and the last solution found
+ * @param options the search options
+ * @param report the report of the search, filled by the function
+ * @return the last solution found, or nullptr if no solution was found
+ */
+TonalPiece* solve_harmoniser(TonalPiece* piece, SearchReport& report, const bool print,
+                             const HarmoniserOptions& options) {
+    /// the clones made by the engines share the new counter of the piece, other searches keep their own counter
+    piece->reset_clones();
+    const auto clones = piece->get_clone_counter();
+    TonalPiece* sol = run_search(piece, report, print, options);
+    report.clones = clones->load();
+    return sol;
+}
+
+/// see solve_harmoniser(TonalPiece*, SearchReport&, bool, const HarmoniserOptions&)
+TonalPiece* solve_harmoniser(TonalPiece* piece, const bool print, const HarmoniserOptions& options) {
+    SearchReport report;
+    return solve_harmoniser(piece, report, print, options);
+}
+
+/**
+ * Extracts the values of a solved piece
+ * @param piece a TonalPiece whose variables are all assigned
+ */
+HarmoniserSolution::HarmoniserSolution(const TonalPiece& piece) :
+    states(intVarArray_to_int_vector(piece.getStates())),
+    qualities(intVarArray_to_int_vector(piece.getQualities())),
+    rootNotes(intVarArray_to_int_vector(piece.getRootNotes())),
+    cost(piece.getCost().val()) {
+    degrees.reserve(piece.getParameters()->get_nProgressions());
+    for (int i = 0; i < piece.getParameters()->get_nProgressions(); i++)
+        degrees.push_back(intVarArray_to_int_vector(piece.getChordProgression(i)->getChords()));
+}
+
+/**
+ * Computes the cost of the soft rules of a piece for this solution, as post_soft_rules does in the model. It is
+ * used by the solvers that do not create a TonalPiece.
+ * @param params the parameters of the piece the solution belongs to
+ * @return the weighted number of violations of the soft rules
+ */
+int HarmoniserSolution::soft_rules_cost(const TonalPieceParameters& params) const {
+    int total = 0;
+    for (const auto& rule : params.get_softRules()) {
+        int violations = 0;
+        switch (rule.type) {
+            case INVERSION_SOFT_RULE:
+                for (const int state : states)
+                    violations += state != FUNDAMENTAL_STATE;
+                break;
+            case PREFERRED_STATE_SOFT_RULE:
+                for (size_t p = 0; p < degrees.size(); p++)
+                    for (size_t i = 0; i < degrees[p].size(); i++)
+                        violations += degrees[p][i] == rule.degree &&
+                                      states[params.get_progressionStart(static_cast<int>(p)) + i] != rule.state;
+                break;
+            case REPEATED_DEGREE_SOFT_RULE:
+                for (const auto& progression : degrees)
+                    for (size_t i = 0; i + 1 < progression.size(); i++)
+                        violations += progression[i] == progression[i + 1];
+                break;
+            case SEVENTH_CHORD_SOFT_RULE:
+                for (const int quality : qualities)
+                    violations += quality >= DOMINANT_SEVENTH_CHORD;
+                break;
+            default:
+                throw std::invalid_argument("Invalid soft rule type");
+        }
+        total += rule.weight * violations;
+    }
+    return total;
+}
+
+/**
+ * Returns the solution on a single line: the cost, then the degrees of each progression separated by commas, the
+ * states, the qualities and the root notes, separated by semicolons.
+ * @return a string representation of the solution
+ */
+string HarmoniserSolution::toString() const {
+    const auto join = [](const vector<int>& values) {
+        string txt;
+        for (size_t i = 0; i < values.size(); i++)
+            txt += (i > 0 ? " " : "") + to_string(values[i]);
+        return txt;
+    };
+    string txt = to_string(cost) + ";";
+    for (size_t i = 0; i < degrees.size(); i++)
+        txt += (i > 0 ? "," : "") + join(degrees[i]);
+    txt += ";" + join(states) + ";" + join(qualities) + ";" + join(rootNotes);
+    return txt;
+}
+
+/**
+ * Returns a sink that writes each solution on a line of the given stream (see HarmoniserSolution::toString). The stream
+ * must outlive the enumeration.
+ * @param os the output stream, e.g. std::cout or a std::ofstream
+ * @return the sink
+ */
+SolutionSink ostream_sink(std::ostream& os) {
+    return [&os](const HarmoniserSolution& sol) {
+        os << sol.toString() << '\n';
+        return static_cast<bool>(os);
+    };
+}
+
+/**
+ * Passes the solutions of the engine to the sink, deleting each space once its values are extracted.
+ * @param engine a search engine on TonalPiece spaces
+ * @param sink the function receiving the solutions
+ * @param maxSolutions the maximal number of solutions, 0 for all of them
+ * @return the number of solutions passed to the sink
+ */
+template<class Engine>
+static unsigned long stream_solutions(Engine& engine, const SolutionSink& sink, const unsigned long maxSolutions) {
+    unsigned long n_sols = 0;
+    while (TonalPiece* sol = engine.next()) {
+        const HarmoniserSolution values(*sol);
+        delete sol;
+        n_sols += 1;
+        if (!sink(values) || (maxSolutions > 0 && n_sols >= maxSolutions))
+            break;
+    }
+    return n_sols;
+}
+
+/**
+ * Enumerates the solutions of a TonalPiece. Each solution is converted to a HarmoniserSolution and passed to the sink,
+ * and its space is deleted right away, so that the memory used does not depend on the number of solutions. In
+ * optimisation mode, only the improving solutions are enumerated. The restart, LNS and portfolio modes are not
+ * supported, as they can return the same solution several times. A piece created without branching gets the default
+ * branching with the seed of the options.
+ * @param piece the TonalPiece to solve, it is deleted by the function
+ * @param sink the function receiving the solutions
+ * @param maxSolutions the maximal number of solutions, 0 for all of them
+ * @param options the search options
+ * @return the number of solutions passed to the sink
+ */
+unsigned long enumerate_harmoniser(TonalPiece* piece, const SolutionSink& sink, const unsigned long maxSolutions,
+                                   const HarmoniserOptions& options) {
+    if (options.restarts || options.lns || options.portfolio) {
+        delete piece;
+        throw std::invalid_argument("The enumeration only supports depth first and branch and bound searches");
+    }
+    if (!piece->has_branching()) {
+        piece->set_seed(options.seed);
+        piece->post_branching(BRANCH_SIZE_RANDOM);
+    }
+    const std::unique_ptr<Search::Stop> stop = make_stop(options);
+    Search::Options opts = engine_options(options, piece->getParameters()->get_size(), stop.get());
+
+    if (options.optimise) {
+        BAB<TonalPiece> engine(piece, opts);
+        delete piece;
+        return stream_solutions(engine, sink, maxSolutions);
+    }
+    DFS<TonalPiece> engine(piece, opts);
+    delete piece;
+    return stream_solutions(engine, sink, maxSolutions);
+}
+
+/**
+ * Solves a batch of independent pieces on a pool of worker threads. Each worker takes the next job that has not been
+ * started, creates its TonalPiece and solves it with solve_harmoniser, so that long and short pieces are balanced
+ * between the workers. The seed and the time and fail limits of the options apply to each job separately.
+ * @param jobs the parameters of each piece, they must outlive the function
+ * @param workers the number of worker threads, 0 for one per core
+ * @param options the search options of every job, the portfolio mode is not supported
+ * @return the result of each job, in the order of the jobs
+ */
+vector<BatchResult> solve_harmoniser_batch(const vector<TonalPieceParameters*>& jobs, const unsigned int workers,
+                                           const HarmoniserOptions& options) {
+    return solve_harmoniser_batch(jobs, workers, options, std::chrono::steady_clock::time_point::max());
+}
+
+/**
+ * Solves a batch of independent pieces before a deadline shared by all the jobs. Each job gets the time left until the
+ * deadline as its time limit, and the jobs that are not started before the deadline are reported as stopped without
+ * being searched. The other options apply to each job as in solve_harmoniser_batch.
+ * @param jobs the parameters of each piece, they must outlive the function
+ * @param workers the number of worker threads, 0 for one per core
+ * @param options the search options of every job, the portfolio mode is not supported
+ * @param deadline the time at which the batch must be finished
+ * @return the result of each job, in the order of the jobs
+ */
+vector<BatchResult> solve_harmoniser_batch(const vector<TonalPieceParameters*>& jobs, unsigned int workers,
+                                           const HarmoniserOptions& options,
+                                           const std::chrono::steady_clock::time_point deadline) {
+    if (options.portfolio)
+        throw std::invalid_argument("The batch solver runs one engine per job, the portfolio mode is not supported");
+    if (workers == 0)
+        workers = std::max(1U, std::thread::hardware_concurrency());
+    workers = std::min(workers, static_cast<unsigned int>(std::max<size_t>(1, jobs.size())));
+
+    vector<BatchResult> results(jobs.size());
+    std::atomic<size_t> next(0);
+    const auto work = [&]() {
+        for (size_t job = next++; job < jobs.size(); job = next++) {
+            BatchResult& result = results[job];
+            HarmoniserOptions jobOptions = options;
+            if (deadline != std::chrono::steady_clock::time_point::max()) {
+                jobOptions.timeLimit = time_left(deadline);
+                if (jobOptions.timeLimit == 0) {
+                    result.report.stopped = true;
+                    continue;
+                }
+            }
+            try {
+                /// the branching is posted by solve_harmoniser with the seed of the options
+                const auto sol = solve_harmoniser(new TonalPiece(jobs[job], false), result.report, false, jobOptions);
+                if (sol != nullptr) {
+                    result.solution = HarmoniserSolution(*sol);
+                    result.solved = true;
+                    delete sol;
+                }
+            } catch (const std::exception& e) {
+                result.error = e.what();
+            }
+        }
+    };
+
+    vector<std::thread> pool;
+    pool.reserve(workers);
+    for (unsigned int i = 0; i < workers; i++)
+        pool.emplace_back(work);
+    for (auto& t : pool)
+        t.join();
+    return results;
+}
+
+/**
+ * Returns the time left until a deadline, to be used as the time limit of a search
+ * @param deadline the deadline
+ * @return the time left in milliseconds, at least 1 if the deadline has not passed, 0 if it has
+ */
+unsigned int time_left(const std::chrono::steady_clock::time_point deadline) {
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= deadline)
+        return 0;
+    const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+    return static_cast<unsigned int>(std::max<long long>(1, left));
 }
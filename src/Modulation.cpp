@@ -3,6 +3,7 @@
 //
 
 #include "../headers/Modulation.hpp"
+#include "../headers/TonalityRegistry.hpp"
 
 /**
  * Constructor for Modulation objects. It initializes the object with the given parameters, and posts the
@@ -14,8 +15,8 @@
  * @param from the chord progression to modulate from
  * @param to the chord progression to modulate to
  */
-Modulation::Modulation(const Home& home, const int type, const int start, const int end, ChordProgression *from, ChordProgression *to):
-    type(type), start(start), end(end), from(from), to(to){
+Modulation::Modulation(const Home& home, const int type, const int start, const int end, ChordProgression &from, ChordProgression &to):
+    type(type), start(start), end(end), fromTonality(from.getTonality()), toTonality(to.getTonality()){
     /// post the constraints based on the type of modulation
     switch(type){
         /**
@@ -24,7 +25,7 @@ Modulation::Modulation(const Home& home, const int type, const int start, const
         case PERFECT_CADENCE_MODULATION:
             if(end - start != 1)
                 throw std::invalid_argument("A perfect cadence modulation must last exactly 2 chords");
-            perfect_cadence_modulation(home);
+            perfect_cadence_modulation(home, from, to);
             break;
         /**
          * A pivot chord (common to both tonalities) is introduced in the first tonality. Then, the rules for both
@@ -33,7 +34,7 @@ Modulation::Modulation(const Home& home, const int type, const int start, const
         case PIVOT_CHORD_MODULATION: //todo check that chromatic chords are accepted as well)
             if(end - start < 2)
                 throw std::invalid_argument("A pivot chord modulation must last at least 3 chords");
-            pivot_chord_modulation(home);
+            pivot_chord_modulation(home, from, to);
             break;
         /**
          * The tonality changes by using a chord from the new key that contains a note that is not in the previous key.
@@ -42,7 +43,7 @@ Modulation::Modulation(const Home& home, const int type, const int start, const
         case ALTERATION_MODULATION:
             if(end - start != 2)
                 throw std::invalid_argument("An alteration modulation must last exactly 3 chords");
-            alteration_modulation(home);
+            alteration_modulation(home, from, to);
             break;
         /**
          * A dominant seventh chord is introduced in the new tonality, that resolves to the I
@@ -50,33 +51,24 @@ Modulation::Modulation(const Home& home, const int type, const int start, const
         case CHROMATIC_MODULATION:
             if(end - start != 1)
                 throw std::invalid_argument("A secondary dominant modulation must last exactly 2 chords");
-            secondary_dominant_modulation(home);
+            secondary_dominant_modulation(home, from, to);
             break;
         default:
             throw std::invalid_argument("Invalid modulation type");
     }
 }
 
-/**
- * Copy constructor
- * @param home the search space
- * @param m a Modulation object
- */
-Modulation::Modulation(const Home &home, const Modulation& m){
-    type = m.type;      start = m.start;        end = m.end;
-    from = new ChordProgression(home, *m.from);
-    to = new ChordProgression(home, *m.to);
-}
-
 /**
  * This function posts the constraints for a perfect cadence modulation. It ensures that the first chord progression
  * ends in a perfect cadence.
  * @param home the search space
+ * @param from the chord progression to modulate from
+ * @param to the chord progression to modulate to
  */
-void Modulation::perfect_cadence_modulation(const Home &home) const {
+void Modulation::perfect_cadence_modulation(const Home &home, ChordProgression &from, ChordProgression &to) const {
     ///Add a perfect cadence constraint to the end of the first tonality
-    cadence(home, from->getDuration()-2, PERFECT_CADENCE, from->getStates(), from->getChords(),
-            from->getHasSeventh());
+    cadence(home, from.getDuration()-2, PERFECT_CADENCE, from.getStates(), from.getChords(),
+            from.getQualities());
 }
 
 /**
@@ -84,15 +76,17 @@ void Modulation::perfect_cadence_modulation(const Home &home) const {
  * to the end minus two chords, all chords are in both tonalities. The last two chords of the modulation are a perfect
  * cadence in the new tonality
  * @param home the search space
+ * @param from the chord progression to modulate from
+ * @param to the chord progression to modulate to
  */
-void Modulation::pivot_chord_modulation(const Home &home) const {
+void Modulation::pivot_chord_modulation(const Home &home, ChordProgression &from, ChordProgression &to) const {
     //todo the pivot chord must be I,II,IV,V,VI in the new tonality
     /// The pivot chord (last from the first tonality and first from the second tonality) must be a diatonic or borrowed chord (not VII)
-    const int mod_start_in_from = start - from->getStart();
-    rel(home, from->getChords()[mod_start_in_from] != SEVENTH_DEGREE);
+    const int mod_start_in_from = start - from.getStart();
+    rel(home, from.getChords()[mod_start_in_from] != SEVENTH_DEGREE);
     ///The modulation must end on a perfect cadence in the new tonality
-    cadence(home, end-1 - to->getStart(), PERFECT_CADENCE, to->getStates(),
-            to->getChords(), to->getHasSeventh());
+    cadence(home, end-1 - to.getStart(), PERFECT_CADENCE, to.getStates(),
+            to.getChords(), to.getQualities());
 }
 
 /**
@@ -100,76 +94,63 @@ void Modulation::pivot_chord_modulation(const Home &home) const {
  * chord, and that the first chord of the new tonality contains at least one note that is not in the first tonality. It also
  * enforces that the V chord of the new tonality must be at the second or third position in the new tonality's section.
  * @param home the search space
+ * @param from the chord progression to modulate from
+ * @param to the chord progression to modulate to
  */
-void Modulation::alteration_modulation(Home home) const {
+void Modulation::alteration_modulation(Home home, ChordProgression &from, ChordProgression &to) const {
     /// The last chord of the first tonality must be diatonic and not the seventh degree without a seventh
-    rel(home, from->getChords()[from->getDuration()-1] < SEVENTH_DEGREE);
-    rel(home, from->getHasSeventh()[from->getDuration()-1] == 0);
+    rel(home, from.getChords()[from.getDuration()-1] < SEVENTH_DEGREE);
+    rel(home, from.getQualities()[from.getDuration()-1] < DOMINANT_SEVENTH_CHORD);
 
     /// The first chord of the modulation must be diatonic and not the fifth degree. It cannot have a seventh
-    rel(home, to->getChords()[0] <= SEVENTH_DEGREE);
-    rel(home, to->getChords()[0] != FIFTH_DEGREE);
-    rel(home, to->getHasSeventh()[0] == 0);
+    rel(home, to.getChords()[0] <= SEVENTH_DEGREE);
+    rel(home, to.getChords()[0] != FIFTH_DEGREE);
+    rel(home, to.getQualities()[0] < DOMINANT_SEVENTH_CHORD);
 
-    /// Get the diatonic note for each degree in the first tonality. Then, add the other notes in the end (they don't
-    /// have a degree, but it is useful to post the constraint). This way all notes are in the array, and we can use an
-    /// element constraint
-    vector<int> t1degreeNotes;      t1degreeNotes.reserve(PERFECT_OCTAVE);
-    for(int i = FIRST_DEGREE; i <= SEVENTH_DEGREE; i++) { /// Add the degree notes
-        t1degreeNotes.push_back(from->getTonality()->get_degree_note(i));
-    }
-    for(int i = C; i <= B; i++){ /// Add the other notes
-        /// if the note is not in the array
-        if(std::find(t1degreeNotes.begin(), t1degreeNotes.end(), i) == t1degreeNotes.end()){
-            t1degreeNotes.push_back(i); /// add it at the end
-        }
-    }
-    const IntArgs t1Notes(t1degreeNotes); /// Create the argument array for the constraint
-
-    /// Get the quality associated to each degree in the first tonality. Then, add -1 for every note that is not associated
-    /// to a degree in the tonality. This way, we can use an element constraint to link the degree and the quality
-    vector<int> t1QualitiesDegrees;     t1QualitiesDegrees.reserve(PERFECT_OCTAVE);
-    for(int i = FIRST_DEGREE; i <= SEVENTH_DEGREE; i++) { /// Add the qualities for the degrees
-        t1QualitiesDegrees.push_back(from->getTonality()->get_chord_quality(i));
-    }
-    while(t1QualitiesDegrees.size() < t1degreeNotes.size()) {
-        t1QualitiesDegrees.push_back(-1); /// fake qualities to have the right number of elements
-    }
-    const IntArgs t1Qualities(t1QualitiesDegrees); /// Create the argument array for the constraint
+    /// The diatonic note of each degree in the first tonality, followed by the other notes (they don't have a degree,
+    /// but it is useful to post the constraint), and the quality of each of these notes (-1 if it has no degree). These
+    /// tables are precomputed by the TonalityRegistry.
+    const TonalityTables& t1 = TonalityRegistry::get_tables(from.getTonality());
 
     /// The corresponding degree and quality in T1 for the note in the new tonality
     const IntVar degreeInT1(home, FIRST_DEGREE, PERFECT_OCTAVE - 1); /// If it is not in the tonality, it is above the seventh degree
     const IntVar qualityInT1(home, -1, AUGMENTED_CHORD); /// Simplified quality without the seventh in T1
 
     /// degreeInT1 is the degree corresponding to the note in the first tonality. If it does not exist,
-    /// it has a fake degree value (above seventh degree)
-    element(home, t1Notes, degreeInT1, expr(home, to->getRootNotes()[0] % PERFECT_OCTAVE));
+    /// it has a fake degree value (above seventh degree). noteToDegree is the inverse of the notes table, so the root
+    /// note is used directly as the index
+    element(home, t1.noteToDegree, to.getRootNotes()[0], degreeInT1);
     /// link quality and degreeInT1. If the degree is fake, the quality is -1
-    element(home, t1Qualities, degreeInT1, qualityInT1);
+    element(home, t1.alterationQualities, degreeInT1, qualityInT1);
     /// the quality of the chord in the new tonality cannot be the same as the quality for the same note in t1.
     /// if the note is not in t1, it is always true because quality is -1. Otherwise the constraint is enforced.
-    rel(home, qualityInT1 != to->getQualitiesWithoutSeventh()[0]);
+    if (to.isLean())    /// there is no variable for the quality without the seventh, it is looked up in the table
+        rel(home, qualityInT1 != element(simpleQualities, to.getQualities()[0]));
+    else
+        rel(home, qualityInT1 != to.getQualitiesWithoutSeventh()[0]);
     // element (home, majorDegreeQualities, expr(home, degreeInT1 * nSupportedQualities + qualityInT1), expr(home,!isRootNoteInT1)); old version, not working
 
     const BoolVar canNextChordBeV(home, 0, 1); /// If the next chord can be the V chord
-    element(home, tonalTransitions, expr(home, to->getChords()[0] * nSupportedChords + FIFTH_DEGREE), canNextChordBeV);
+    element(home, tonalTransitions, expr(home, to.getChords()[0] * nSupportedChords + FIFTH_DEGREE), canNextChordBeV);
     /// If the next chord can be the V, then it is
-    rel(home, canNextChordBeV, BOT_EQV, expr(home, to->getChords()[1] == FIFTH_DEGREE), true);
+    rel(home, canNextChordBeV, BOT_EQV, expr(home, to.getChords()[1] == FIFTH_DEGREE), true);
     /// If the next chord cannot be the V, then the third chord is
-    rel(home, expr(home, !canNextChordBeV), BOT_IMP, expr(home, to->getChords()[2] == FIFTH_DEGREE), true);
+    rel(home, expr(home, !canNextChordBeV), BOT_IMP, expr(home, to.getChords()[2] == FIFTH_DEGREE), true);
 }
 
 /**
  * This function posts the constraints for a secondary dominant modulation. It ensures that the first chord of the new tonality
  * is the V chord, and that the last chord of the first tonality contains the note below the leading tone of the new tonality.
  * @param home the search space
+ * @param from the chord progression to modulate from
+ * @param to the chord progression to modulate to
  */
-void Modulation::secondary_dominant_modulation(const Home& home) const {
-    rel(home, to->getChords()[0] == FIFTH_DEGREE); /// The first chord of the new tonality must be the V chord
-    rel(home, from->getChords()[from->getDuration() - 1] <= SEVENTH_DEGREE); /// The last chord before the V must be diatonic
+void Modulation::secondary_dominant_modulation(const Home& home, ChordProgression &from, ChordProgression &to) const {
+    rel(home, to.getChords()[0] == FIFTH_DEGREE); /// The first chord of the new tonality must be the V chord
+    rel(home, from.getChords()[from.getDuration() - 1] <= SEVENTH_DEGREE); /// The last chord before the V must be diatonic
 
     /// calculer la distance entre les tonalités ( abs(dest - orig) % 7),
-    int tonics_interval = (to->getTonality()->get_tonic() - from->getTonality()->get_tonic()) % PERFECT_OCTAVE;
+    int tonics_interval = (to.getTonality()->get_tonic() - from.getTonality()->get_tonic()) % PERFECT_OCTAVE;
     if (tonics_interval < 0)
         tonics_interval = PERFECT_OCTAVE + tonics_interval; /// reverse it -> descending third = ascending sixth
     int degree_tonics_interval = 0;
@@ -201,10 +182,14 @@ void Modulation::secondary_dominant_modulation(const Home& home) const {
     }
 
     const int degree_of_new_seventh_in_from = (degree_tonics_interval + 6) % 7;
-    /// this degree must be in the chord before the V
-    rel(home, expr(home, from->getRoots()[from->getDuration()-1] == degree_of_new_seventh_in_from ||
-                            from->getThirds()[from->getDuration()-1] == degree_of_new_seventh_in_from ||
-                            from->getFifths()[from->getDuration()-1] == degree_of_new_seventh_in_from));
+    /// this degree must be the root, the third or the fifth of the chord before the V
+    IntArgs chordsWithNote;
+    for (int chord = FIRST_DEGREE; chord < nSupportedChords; chord++) {
+        const int state = statesByBassMatrix[chord * 7 + degree_of_new_seventh_in_from];
+        if (state >= FUNDAMENTAL_STATE && state <= SECOND_INVERSION)
+            chordsWithNote << chord;
+    }
+    dom(home, from.getChords()[from.getDuration()-1], IntSet(chordsWithNote));
 }
 
 /**
@@ -217,8 +202,8 @@ string Modulation::toString() const {
     txt += "Type: " + to_string(type) + "\n";
     txt += "Start: " + to_string(start) + "\n";
     txt += "End: " + to_string(end) + "\n";
-    txt += "From: " + from->getTonality()->get_name() + "\n";
-    txt += "To: " + to->getTonality()->get_name() + "\n";
+    txt += "From: " + fromTonality->get_name() + "\n";
+    txt += "To: " + toTonality->get_name() + "\n";
     return txt;
 }
 
@@ -229,7 +214,7 @@ string Modulation::toString() const {
 string Modulation::pretty() const {
     string txt;
     try{
-        txt += "from " + from->getTonality()->get_name() + " to " + to->getTonality()->get_name() + " (" + modulation_type_names[type] + ")";
+        txt += "from " + fromTonality->get_name() + " to " + toTonality->get_name() + " (" + modulation_type_names[type] + ")";
     }
     catch(...){
         std::cout << "Some variables are unbound in the modulation object" << std::endl;
@@ -26,15 +26,45 @@ using namespace Gecode;
  * @param maxChromaticChords the maximum number of chromatic chords in the progression
  * @param minSeventhChords the minimum number of seventh chords in the progression
  * @param maxSeventhChords the maximum number of seventh chords in the progression
+ * @param options how the constraints are posted in the model
  */
 void tonal_progression(const Home& home, const int size, Tonality *tonality, const IntVarArray &states, const IntVarArray &qualities,
                        const IntVarArray &rootNotes, const IntVarArray &chords, const IntVarArray &bassDegrees, const IntVarArray &isChromatic,
                        const IntVarArray &hasSeventh, const IntVarArray& roots, const IntVarArray& thirds, const IntVarArray& fifths,
                        const IntVarArray& sevenths, const int minChromaticChords, const int maxChromaticChords, const int minSeventhChords,
-                       const int maxSeventhChords) {
-    ///1. chord[i] -> chord[i+1] is possible
-    chord_transitions(home, size, chords);
-
+                       const int maxSeventhChords, const ModelOptions& options) {
+    ///1. chord[i] -> chord[i+1] is possible. The automaton also covers 13. and 17.
+    if (options.transitionAutomaton)
+        regular_chord_transitions(home, chords, tonality);
+    else
+        chord_transitions(home, size, chords);
+
+    /// Lean model: there are no auxiliary variables, the rules on one chord are in the lean chord table and the rules
+    /// on successive chords are checked by the propagator with table lookups
+    if (options.leanSpace) {
+        link_chords_with_lean_table(home, size, tonality, chords, states, qualities, rootNotes, minChromaticChords,
+                                    maxChromaticChords, minSeventhChords, maxSeventhChords);
+        fifth_degree_appogiatura(home, size, states, qualities, chords);
+        successive_chords_with_same_degree(home, size, states, qualities, chords, !options.transitionAutomaton);
+        voice_leading_rules(home, chords, states, qualities);
+        return;
+    }
+
+    /// Table model: rules 2-9, 11, 15, 17 and 18 only involve one chord, they are all in the chord table
+    if (options.tableModel) {
+        link_chords_with_table(home, size, tonality, chords, states, qualities, bassDegrees, roots, thirds, fifths,
+                               sevenths, rootNotes, isChromatic, hasSeventh, minChromaticChords, maxChromaticChords,
+                               minSeventhChords, maxSeventhChords);
+        fifth_degree_appogiatura(home, size, states, qualities, chords);
+        successive_chords_with_same_degree(home, size, states, qualities, chords, !options.transitionAutomaton);
+        if (options.voiceLeadingPropagator)
+            voice_leading_rules(home, chords, states, qualities);
+        else {
+            tritone_resolutions(home, size, states, qualities, chords, bassDegrees);
+            seventh_chords_preparation(home, size, hasSeventh, qualities, chords, roots, thirds, fifths, sevenths);
+        }
+        return;
+    }
 
     ///2. Link notes to degrees
     link_notes_to_degree(home, size, chords, roots, thirds, fifths, sevenths);
@@ -68,22 +98,30 @@ void tonal_progression(const Home& home, const int size, Tonality *tonality, con
 
     ///12. If two successive chords are the same degree, they cannot have the same state or the same quality
     ///13. The same degree cannot happen more than twice successively
-    successive_chords_with_same_degree(home, size, states, qualities, chords);
+    successive_chords_with_same_degree(home, size, states, qualities, chords, !options.transitionAutomaton);
 
     ///14. Tritone resolutions should be allowed with the states
-    tritone_resolutions(home, size, states, qualities, chords, bassDegrees);
+    if (!options.voiceLeadingPropagator)
+        tritone_resolutions(home, size, states, qualities, chords, bassDegrees);
 
     ///15. Chords cannot be in third inversion if they don't have a seventh
     chord_states_and_qualities(home, size, states, qualities);
 
     ///16. 7èmes d'espèces doivent être préparées
-    seventh_chords_preparation(home, size, hasSeventh, qualities, chords, roots, thirds, fifths, sevenths);
+    if (!options.voiceLeadingPropagator)
+        seventh_chords_preparation(home, size, hasSeventh, qualities, chords, roots, thirds, fifths, sevenths);
 
     ///17. V/VII can only be used in minor mode
-    five_of_seven(home, size, chords, tonality);
+    if (!options.transitionAutomaton)
+        five_of_seven(home, size, chords, tonality);
 
     ///18. Diminished seventh chords
-    diminished_seventh_dominant_chords(home, size, qualities, chords, states);
+    if (!options.voiceLeadingPropagator)
+        diminished_seventh_dominant_chords(home, size, qualities, chords, states);
+
+    ///14., 16. and 18. with a single propagator
+    if (options.voiceLeadingPropagator)
+        voice_leading_rules(home, chords, states, qualities);
 
 }
 
@@ -0,0 +1,92 @@
+//
+// Created on 16/10/2026.
+//
+
+#include "../headers/ResolveSession.hpp"
+
+/**
+ * Creates a session on a solution of the piece. The solution is checked against the model of the piece.
+ * @param params the parameters of the piece, they must outlive the session
+ * @param solution a solution of the piece
+ * @throws std::invalid_argument if the solution does not have the shape of the piece or violates its constraints
+ */
+ResolveSession::ResolveSession(TonalPieceParameters* params, HarmoniserSolution solution) :
+    parameters(params), root(new TonalPiece(params, false)), solution(std::move(solution)), seed(1U) {
+    if (root->status() == SS_FAILED)
+        throw std::invalid_argument("The piece has no solution");
+
+    /// the windows are re-solved around the solution, which must therefore be a solution of the piece
+    const HarmoniserSolution& sol = this->solution;
+    if (sol.degrees.size() != static_cast<size_t>(params->get_nProgressions()) ||
+        sol.states.size() != static_cast<size_t>(params->get_size()) ||
+        sol.qualities.size() != static_cast<size_t>(params->get_size()))
+        throw std::invalid_argument("The solution does not have the size of the piece");
+    for (int k = 0; k < params->get_nProgressions(); k++)
+        if (sol.degrees[k].size() != static_cast<size_t>(params->get_progressionDuration(k)))
+            throw std::invalid_argument("The solution does not have the progressions of the piece");
+    const std::unique_ptr<TonalPiece> check(static_cast<TonalPiece*>(root->clone()));
+    check->fix(sol.degrees, sol.states, sol.qualities, {});
+    if (check->status() == SS_FAILED)
+        throw std::invalid_argument("The solution violates the constraints of the piece");
+}
+
+/**
+ * Creates a session and solves the piece with solve_harmoniser
+ * @param params the parameters of the piece, they must outlive the session
+ * @param options the search options
+ */
+ResolveSession::ResolveSession(TonalPieceParameters* params, const HarmoniserOptions& options) :
+    parameters(params), root(new TonalPiece(params, false)), seed(options.seed + 1) {
+    if (root->status() == SS_FAILED)
+        throw std::invalid_argument("The piece has no solution");
+    const auto piece = static_cast<TonalPiece*>(root->clone());
+    piece->set_seed(options.seed);
+    piece->post_branching(BRANCH_SIZE_RANDOM);
+    const auto sol = solve_harmoniser(piece, false, options);
+    if (sol == nullptr)
+        throw std::runtime_error("No solution was found for the piece");
+    solution = HarmoniserSolution(*sol);
+    delete sol;
+}
+
+/**
+ * Re-solves a window of the piece. The chords outside of the window keep their values. If a new solution is found,
+ * it becomes the current solution.
+ * @param first the position of the first chord of the window
+ * @param last the position of the last chord of the window
+ * @param different if true, the window must differ from the current solution on at least one chord
+ * @param options the search options, typically with a time limit for interactive uses
+ * @return true if a new solution was found
+ */
+bool ResolveSession::resolve(const int first, const int last, const bool different, const HarmoniserOptions& options) {
+    if (first < 0 || last >= parameters->get_size() || first > last)
+        throw std::invalid_argument("Invalid window");
+    if (options.portfolio || options.lns)
+        throw std::invalid_argument("The portfolio and LNS modes are not supported to re-solve a window");
+
+    const auto piece = static_cast<TonalPiece*>(root->clone());
+    piece->fix(solution.degrees, solution.states, solution.qualities, {{first, last}});
+    if (different) {
+        /// at least one variable of the window takes another value
+        BoolVarArgs changes;
+        for (int i = first; i <= last; i++) {
+            changes << expr(*piece, piece->getStates()[i]       != solution.states[i]);
+            changes << expr(*piece, piece->getQualities()[i]    != solution.qualities[i]);
+        }
+        for (int k = 0; k < parameters->get_nProgressions(); k++) {
+            const ChordProgression* p = piece->getChordProgression(k);
+            for (int i = std::max(first, p->getStart()); i <= std::min(last, p->getStart() + p->getDuration() - 1); i++)
+                changes << expr(*piece, p->getChords()[i - p->getStart()] != solution.degrees[k][i - p->getStart()]);
+        }
+        rel(*piece, BOT_OR, changes, 1);
+    }
+    piece->set_seed(seed++);
+    piece->post_branching(BRANCH_SIZE_RANDOM);
+
+    const auto sol = solve_harmoniser(piece, false, options);
+    if (sol == nullptr)
+        return false;
+    solution = HarmoniserSolution(*sol);
+    delete sol;
+    return true;
+}
@@ -0,0 +1,126 @@
+//
+// Created on 16/10/2026.
+//
+
+#include "../headers/RollingGenerator.hpp"
+
+/// the number of chords carried from one piece to the next, enough for the rules on three successive chords
+constexpr int carriedChords = 2;
+
+/**
+ * Returns the number of chords of a modulation
+ * @param type the type of the modulation
+ * @return the number of chords
+ */
+static int modulation_length(const int type) {
+    switch (type) {
+        case PERFECT_CADENCE_MODULATION:
+        case CHROMATIC_MODULATION:
+            return 2;
+        case PIVOT_CHORD_MODULATION:
+        case ALTERATION_MODULATION:
+            return 3;
+        default:
+            throw std::invalid_argument("Invalid modulation type");
+    }
+}
+
+/**
+ * Constructor
+ * @param tonality the tonality of the first chords
+ * @param horizon the number of new chords in each piece
+ * @param commit the number of chords committed after each piece, at most horizon
+ * @param options the search options of each piece, the portfolio and LNS modes are not supported
+ * @param modelOptions how the constraints are posted in each piece
+ */
+RollingGenerator::RollingGenerator(Tonality* tonality, const int horizon, const int commit,
+                                   const HarmoniserOptions& options, const ModelOptions& modelOptions) :
+    tonality(tonality), horizon(horizon), commit(commit), options(options), modelOptions(modelOptions),
+    nextTonality(nullptr), nextModulation(-1), generated(0) {
+    if (commit < 1 || commit > horizon)
+        throw std::invalid_argument("The number of committed chords must be between 1 and the horizon");
+    if (options.portfolio || options.lns)
+        throw std::invalid_argument("The portfolio and LNS modes are not supported by the rolling generator");
+}
+
+/**
+ * Requests a modulation at the beginning of the next piece
+ * @param to the new tonality
+ * @param modulationType the type of the modulation
+ */
+void RollingGenerator::modulate(Tonality* to, const int modulationType) {
+    /// the modulation starts after the first new chord, and the carried chords of the next piece are in the new tonality
+    if (horizon < modulation_length(modulationType) + 1 + carriedChords ||
+        commit < modulation_length(modulationType) + 1 + carriedChords)
+        throw std::invalid_argument("The horizon and the number of committed chords are too short for the modulation");
+    nextTonality = to;
+    nextModulation = modulationType;
+}
+
+/**
+ * Solves the next piece and commits its first chords
+ * @return the committed chords
+ */
+vector<GeneratedChord> RollingGenerator::next() {
+    const int carry = static_cast<int>(carried.size());
+    const int size = carry + horizon;
+
+    vector<Tonality*> tonalities = {tonality};
+    vector<int> modulationTypes, modulationStarts, modulationEnds;
+    if (nextTonality != nullptr) {
+        tonalities.push_back(nextTonality);
+        modulationTypes.push_back(nextModulation);
+        modulationStarts.push_back(carry + 1);
+        modulationEnds.push_back(carry + modulation_length(nextModulation));
+    }
+    TonalPieceParameters params(size, static_cast<int>(tonalities.size()), tonalities, modulationTypes,
+                                modulationStarts, modulationEnds);
+    params.set_modelOptions(modelOptions);
+
+    auto piece = new TonalPiece(&params, false);
+    if (carry > 0) {
+        /// the carried chords are at the beginning of the first progression
+        vector<vector<int>> degrees(params.get_nProgressions());
+        for (int k = 0; k < params.get_nProgressions(); k++)
+            degrees[k].resize(params.get_progressionDuration(k));
+        vector<int> states(size), qualities(size);
+        for (int i = 0; i < carry; i++) {
+            degrees[0][i]   = carried[i].degree;
+            states[i]       = carried[i].state;
+            qualities[i]    = carried[i].quality;
+        }
+        piece->fix(degrees, states, qualities, {{carry, size - 1}});
+    }
+    piece->set_seed(options.seed + static_cast<unsigned int>(generated));
+    piece->post_branching(BRANCH_SIZE_RANDOM);
+
+    SearchReport report;
+    const auto sol = solve_harmoniser(piece, report, false, options);
+    if (sol == nullptr)
+        throw std::runtime_error(report.stopped ? "The search of the next chords was stopped by a limit" :
+                                                  "The progression cannot be continued");
+
+    /// commit the first chords, in the last tonality they belong to
+    vector<GeneratedChord> committed;
+    committed.reserve(commit);
+    for (int i = carry; i < carry + commit; i++) {
+        int k = params.get_nProgressions() - 1;
+        while (params.get_progressionStart(k) > i)
+            k--;
+        const ChordProgression* p = sol->getChordProgression(k);
+        committed.push_back(GeneratedChord{params.get_tonality(k), p->getChords()[i - p->getStart()].val(),
+                                           sol->getStates()[i].val(), sol->getQualities()[i].val(),
+                                           sol->getRootNotes()[i].val()});
+    }
+    delete sol;
+
+    /// carry the last chords
+    carried.insert(carried.end(), committed.begin(), committed.end());
+    carried.erase(carried.begin(), carried.end() - std::min<int>(carriedChords, static_cast<int>(carried.size())));
+    if (nextTonality != nullptr) {
+        tonality = nextTonality;
+        nextTonality = nullptr;
+    }
+    generated += commit;
+    return committed;
+}
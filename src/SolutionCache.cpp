@@ -0,0 +1,143 @@
+//
+// Created on 16/10/2026.
+//
+
+#include "../headers/SolutionCache.hpp"
+
+/**
+ * Constructor
+ * @param capacity the maximal number of solutions in the cache
+ */
+SolutionCache::SolutionCache(const size_t capacity) : capacity(capacity), hits(0), misses(0) {
+    if (capacity == 0)
+        throw std::invalid_argument("The capacity of the cache must be positive");
+}
+
+/**
+ * Returns the canonical key of a piece: its size, the mode of each tonality and the interval between its tonic and
+ * the first tonic, the type, start and end of each modulation, the soft rules, the model options and the search
+ * options that change the solution found (the seed, the optimisation, and the restarts with their cutoff sequence
+ * and nogoods).
+ * @param params the parameters of the piece
+ * @param options the search options
+ * @return the canonical key
+ */
+string SolutionCache::canonical_key(const TonalPieceParameters& params, const HarmoniserOptions& options) {
+    const int firstTonic = params.get_tonality(0)->get_tonic();
+    string key = to_string(params.get_size()) + "|";
+    for (int i = 0; i < params.get_nProgressions(); i++)
+        key += to_string(params.get_tonality(i)->get_mode()) + ":" +
+               to_string(((params.get_tonality(i)->get_tonic() - firstTonic) % PERFECT_OCTAVE + PERFECT_OCTAVE) %
+                         PERFECT_OCTAVE) + ",";
+    key += "|";
+    for (int i = 0; i < params.get_nProgressions() - 1; i++)
+        key += to_string(params.get_modulationType(i)) + ":" + to_string(params.get_modulationStart(i)) + ":" +
+               to_string(params.get_modulationEnd(i)) + ",";
+    key += "|";
+    for (const auto& rule : params.get_softRules())
+        key += to_string(rule.type) + ":" + to_string(rule.weight) + ":" + to_string(rule.degree) + ":" +
+               to_string(rule.state) + ",";
+    const ModelOptions& model = params.get_modelOptions();
+    key += "|" + to_string(model.tableModel) + to_string(model.transitionAutomaton) +
+           to_string(model.voiceLeadingPropagator) + to_string(model.leanSpace);
+    key += "|" + to_string(options.seed) + ":" + to_string(options.optimise);
+    if (options.restarts)
+        key += ":" + to_string(options.cutoff) + ":" + to_string(options.cutoffScale) + ":" +
+               to_string(options.geometricBase) + ":" + to_string(options.nogoodsLimit);
+    return key;
+}
+
+/**
+ * Looks for a solution of the piece or one of its transpositions. If one is found, its root notes are transposed
+ * to the tonics of the piece.
+ * @param params the parameters of the piece
+ * @param options the search options
+ * @param solution the solution, set if one is found
+ * @return true if a solution was found
+ */
+bool SolutionCache::lookup(const TonalPieceParameters& params, const HarmoniserOptions& options,
+                           HarmoniserSolution& solution) {
+    const string key = canonical_key(params, options);
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = index.find(key);
+    if (it == index.end()) {
+        misses++;
+        return false;
+    }
+    hits++;
+    entries.splice(entries.begin(), entries, it->second);     /// most recently used
+
+    solution = it->second->solution;
+    const int interval = params.get_tonality(0)->get_tonic() - it->second->tonic;
+    for (auto& note : solution.rootNotes)
+        note = ((note + interval) % PERFECT_OCTAVE + PERFECT_OCTAVE) % PERFECT_OCTAVE;
+    return true;
+}
+
+/**
+ * Adds the solution of a piece to the cache, evicting the least recently used solution if the cache is full.
+ * @param params the parameters of the piece
+ * @param options the search options the solution was found with
+ * @param solution the solution
+ */
+void SolutionCache::insert(const TonalPieceParameters& params, const HarmoniserOptions& options,
+                           const HarmoniserSolution& solution) {
+    string key = canonical_key(params, options);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (index.count(key) > 0)
+        return;
+    if (entries.size() >= capacity) {
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+    entries.push_front(Entry{key, params.get_tonality(0)->get_tonic(), solution});
+    index.emplace(std::move(key), entries.begin());
+}
+
+size_t SolutionCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+unsigned long SolutionCache::get_hits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+}
+
+unsigned long SolutionCache::get_misses() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+}
+
+/**
+ * Solves a piece with solve_harmoniser, unless a solution of the piece or one of its transpositions is in the cache. The
+ * piece is created from the parameters with the seed of the options, and its solution is added to the cache.
+ * @param params the parameters of the piece
+ * @param cache the solution cache
+ * @param solution the solution, set if one is found
+ * @param options the search options, the portfolio and LNS modes are not supported as their solutions are not
+ * reproducible
+ * @return true if a solution was found
+ */
+bool solve_harmoniser_cached(TonalPieceParameters* params, SolutionCache& cache, HarmoniserSolution& solution,
+                             const HarmoniserOptions& options) {
+    if (options.portfolio || options.lns)
+        throw std::invalid_argument("The solutions of the portfolio and LNS modes cannot be cached");
+    if (cache.lookup(*params, options, solution))
+        return true;
+
+    auto piece = new TonalPiece(params, false);
+    piece->set_seed(options.seed);
+    piece->post_branching(BRANCH_SIZE_RANDOM);
+
+    SearchReport report;
+    const auto sol = solve_harmoniser(piece, report, false, options);
+    if (sol == nullptr)
+        return false;
+    solution = HarmoniserSolution(*sol);
+    delete sol;
+    /// a solution found before a limit is valid, but it is not the one the complete search would give
+    if (!report.stopped || !options.optimise)
+        cache.insert(*params, options, solution);
+    return true;
+}
@@ -0,0 +1,109 @@
+//
+// Created on 16/10/2026.
+//
+
+#include "../headers/SolutionCounter.hpp"
+
+/**
+ * Compiles the rules of the piece into the layered graph and counts its solutions
+ * @param params the parameters of a piece with a single tonality
+ */
+SolutionCounter::SolutionCounter(TonalPieceParameters* params) : parameters(params) {
+    if (params->get_nProgressions() != 1)
+        throw std::invalid_argument("The solutions can only be counted for pieces with a single tonality");
+    if (params->get_size() < 1)
+        throw std::invalid_argument("The solutions can only be counted for pieces with at least one chord");
+    tables = &TonalityRegistry::get_tables(params->get_tonality(0));
+
+    const auto& chords = tables->chords;
+    const int n = static_cast<int>(tables->chords.size());
+    successors.resize(n);
+    for (int a = 0; a < n; a++)
+        for (int b = 0; b < n; b++)
+            if (tables->successors[a].test(b))
+                successors[a].push_back(b);
+
+    /// the last chord can end the piece from any node, then count backwards
+    const int size = params->get_size();
+    completions.assign(size, vector<BigUInt>(2 * n));
+    for (int node = 0; node < 2 * n; node++)
+        completions[size - 1][node] = 1;
+    for (int i = size - 2; i >= 0; i--)
+        for (int a = 0; a < n; a++)
+            for (const bool repeated : {false, true})
+                for (const int b : successors[a]) {
+                    const bool same = chords[a][0] == chords[b][0];
+                    if (repeated && same)       /// the same degree cannot happen more than twice successively
+                        continue;
+                    completions[i][2 * a + repeated] += completions[i + 1][2 * b + same];
+                }
+    for (int a = 0; a < n; a++)
+        total += completions[0][2 * a];
+}
+
+/**
+ * Builds the solution corresponding to a path in the graph
+ * @param path the index of the chord at each position
+ * @return the solution
+ */
+HarmoniserSolution SolutionCounter::to_solution(const vector<int>& path) const {
+    HarmoniserSolution sol;
+    sol.degrees.emplace_back();
+    for (const int c : path) {
+        sol.degrees[0]  .push_back(tables->chords[c][0]);
+        sol.states      .push_back(tables->chords[c][1]);
+        sol.qualities   .push_back(tables->chords[c][2]);
+        sol.rootNotes   .push_back(tables->degreeNotes[tables->chords[c][0]]);
+    }
+    sol.cost = sol.soft_rules_cost(*parameters);
+    return sol;
+}
+
+/**
+ * Returns the solution at the given index, the solutions being ordered lexicographically on (degree, state,
+ * quality) from the first chord to the last
+ * @param index a number lower than count()
+ * @return the solution
+ */
+HarmoniserSolution SolutionCounter::solution(BigUInt index) const {
+    if (!(index < total))
+        throw std::out_of_range("The index is not lower than the number of solutions");
+    vector<int> path;
+    path.reserve(parameters->get_size());
+    /// at each position, skip the subtrees of the chords that come before the solution
+    for (int a = 0; a < static_cast<int>(tables->chords.size()); a++) {
+        if (index < completions[0][2 * a]) {
+            path.push_back(a);
+            break;
+        }
+        index -= completions[0][2 * a];
+    }
+    bool repeated = false;
+    for (int i = 1; i < parameters->get_size(); i++) {
+        const int a = path.back();
+        for (const int b : successors[a]) {
+            const bool same = tables->chords[a][0] == tables->chords[b][0];
+            if (repeated && same)
+                continue;
+            const BigUInt& subtree = completions[i][2 * b + same];
+            if (index < subtree) {
+                path.push_back(b);
+                repeated = same;
+                break;
+            }
+            index -= subtree;
+        }
+    }
+    return to_solution(path);
+}
+
+/**
+ * Returns a solution drawn uniformly among all the solutions of the piece
+ * @param rng the random generator
+ * @return the solution
+ */
+HarmoniserSolution SolutionCounter::sample(std::mt19937_64& rng) const {
+    if (total.is_zero())
+        throw std::runtime_error("The piece has no solution");
+    return solution(BigUInt::random_below(total, rng));
+}
@@ -0,0 +1,301 @@
+//
+// Created on 16/10/2026.
+//
+
+#include "../headers/SolutionStore.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// The header at the beginning of the file
+struct StoreHeader {
+    char magic[8];                  /// storeMagic
+    uint32_t version;               /// storeVersion
+    uint32_t nBuckets;              /// the number of buckets of the hash table
+    uint64_t fileSize;              /// the size of the file, fixed at its creation
+    uint64_t dataEnd;               /// the offset of the end of the last record
+    uint64_t nRecords;              /// the number of records
+};
+
+/// The fixed part of a record, followed by the key, the length of each progression and the values
+struct RecordHeader {
+    uint32_t keyLength;             /// the number of bytes of the canonical key
+    uint32_t nChords;               /// the number of chords of the piece
+    uint32_t nProgressions;         /// the number of progressions of the piece
+    int32_t cost;                   /// the cost of the solution
+    int32_t tonic;                  /// the tonic of the first tonality of the piece the solution was computed for
+    uint32_t padding;
+};
+
+constexpr char storeMagic[8]    = {'H', 'A', 'R', 'M', 'S', 'T', 'O', 'R'};
+constexpr uint32_t storeVersion = 1;
+constexpr uint64_t headerSize   = 64;           /// the header is padded so that the buckets are aligned
+constexpr uint64_t bucketSize   = 2 * sizeof(uint64_t);
+
+static_assert(sizeof(StoreHeader) <= headerSize, "The header of the store does not fit in its slot");
+
+/// Holds a lock on a file until it goes out of scope
+struct FileLock {
+    int fd;
+    FileLock(const int fd, const int operation) : fd(fd) { flock(fd, operation); }
+    ~FileLock() { flock(fd, LOCK_UN); }
+};
+
+/**
+ * Returns the offset of the first record in a file with the given number of buckets
+ * @param nBuckets the number of buckets
+ * @return the offset of the data
+ */
+static uint64_t data_start(const uint32_t nBuckets) {
+    return headerSize + nBuckets * bucketSize;
+}
+
+/**
+ * Opens a store, creating the file if it does not exist and the store is writable.
+ * @param path the path of the file
+ * @param writable whether solutions can be added to the store
+ * @param nBuckets the number of buckets of the hash table when the file is created
+ * @param capacity the size of the file in bytes when the file is created
+ */
+SolutionStore::SolutionStore(const string& path, const bool writable, const uint32_t nBuckets, const size_t capacity) :
+    fd(-1), data(nullptr), length(0), writable(writable) {
+    fd = open(path.c_str(), writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open the solution store " + path);
+
+    struct stat st{};
+    {
+        /// the creation of the file is done under an exclusive lock, so other processes never see a partial header
+        FileLock lock(fd, writable ? LOCK_EX : LOCK_SH);
+        fstat(fd, &st);
+        if (st.st_size == 0 && writable) {
+            if (nBuckets == 0 || capacity <= data_start(nBuckets)) {
+                close(fd);
+                throw std::invalid_argument("The capacity of the solution store is too small for its buckets");
+            }
+            StoreHeader header{};
+            std::memcpy(header.magic, storeMagic, sizeof(storeMagic));
+            header.version  = storeVersion;
+            header.nBuckets = nBuckets;
+            header.fileSize = capacity;
+            header.dataEnd  = data_start(nBuckets);
+            if (ftruncate(fd, static_cast<off_t>(capacity)) != 0 ||
+                pwrite(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+                close(fd);
+                throw std::runtime_error("Cannot create the solution store " + path);
+            }
+            fstat(fd, &st);
+        }
+    }
+    length = static_cast<size_t>(st.st_size);
+    if (length < headerSize) {
+        close(fd);
+        throw std::runtime_error("The solution store " + path + " is empty or truncated");
+    }
+
+    void* map = mmap(nullptr, length, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Cannot map the solution store " + path);
+    }
+    data = static_cast<uint8_t*>(map);
+
+    const auto header = reinterpret_cast<const StoreHeader*>(data);
+    if (std::memcmp(header->magic, storeMagic, sizeof(storeMagic)) != 0 || header->version != storeVersion ||
+        header->fileSize != length || data_start(header->nBuckets) > length) {
+        munmap(data, length);
+        close(fd);
+        throw std::runtime_error(path + " is not a valid solution store");
+    }
+}
+
+SolutionStore::~SolutionStore() {
+    munmap(data, length);
+    close(fd);
+}
+
+/**
+ * Returns the 64 bits FNV-1a hash of a string
+ * @param key the string
+ * @return the hash
+ */
+uint64_t SolutionStore::fnv1a(const string& key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char c : key) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * Returns the bucket at the given index
+ * @param i the index of the bucket
+ * @return a pointer to the hash of the bucket, followed by the offset of its record
+ */
+uint64_t* SolutionStore::bucket(const uint64_t i) const {
+    return reinterpret_cast<uint64_t*>(data + headerSize + i * bucketSize);
+}
+
+/**
+ * Looks for the bucket of a key
+ * @param key the canonical key
+ * @param hash the hash of the key
+ * @param offset the offset of the record of the key, 0 if it is not in the store
+ * @return the index of the bucket of the key, or of the first empty bucket on its probing sequence. -1 if the key
+ * is not in the store and the table is full.
+ */
+int64_t SolutionStore::find(const string& key, const uint64_t hash, uint64_t& offset) const {
+    const uint32_t nBuckets = reinterpret_cast<const StoreHeader*>(data)->nBuckets;
+    for (uint64_t probe = 0; probe < nBuckets; probe++) {
+        const uint64_t i = (hash + probe) % nBuckets;
+        uint64_t* b = bucket(i);
+        /// the offset is published after the record and the hash are written
+        offset = __atomic_load_n(&b[1], __ATOMIC_ACQUIRE);
+        if (offset == 0)
+            return static_cast<int64_t>(i);
+        if (b[0] != hash || offset + sizeof(RecordHeader) + key.size() > length)
+            continue;
+        RecordHeader record{};
+        std::memcpy(&record, data + offset, sizeof(record));
+        if (record.keyLength == key.size() &&
+            std::memcmp(data + offset + sizeof(record), key.data(), key.size()) == 0)
+            return static_cast<int64_t>(i);
+    }
+    offset = 0;
+    return -1;
+}
+
+/**
+ * Looks for a solution of the piece or one of its transpositions. If one is found, its root notes are transposed
+ * to the tonics of the piece.
+ * @param params the parameters of the piece
+ * @param options the search options
+ * @param solution the solution, set if one is found
+ * @return true if a solution was found
+ */
+bool SolutionStore::lookup(const TonalPieceParameters& params, const HarmoniserOptions& options,
+                           HarmoniserSolution& solution) const {
+    const string key = SolutionCache::canonical_key(params, options);
+    uint64_t offset;
+    find(key, fnv1a(key), offset);
+    if (offset == 0)
+        return false;
+
+    /// the record must lie before the end of the data, which is published before the offset of the record
+    const auto header = reinterpret_cast<const StoreHeader*>(data);
+    const uint64_t dataEnd = __atomic_load_n(&header->dataEnd, __ATOMIC_ACQUIRE);
+    if (dataEnd > length || offset < data_start(header->nBuckets) || offset + sizeof(RecordHeader) > dataEnd)
+        return false;
+    RecordHeader record{};
+    std::memcpy(&record, data + offset, sizeof(record));
+    const uint64_t valuesStart = offset + sizeof(record) + record.keyLength +
+                                 static_cast<uint64_t>(record.nProgressions) * sizeof(uint32_t);
+    if (valuesStart > dataEnd)
+        return false;
+    const uint8_t* p = data + offset + sizeof(record) + record.keyLength;
+
+    vector<uint32_t> durations(record.nProgressions);
+    std::memcpy(durations.data(), p, record.nProgressions * sizeof(uint32_t));
+    p += record.nProgressions * sizeof(uint32_t);
+    uint64_t totalDuration = 0;
+    for (const auto d : durations)
+        totalDuration += d;
+    if (totalDuration < record.nChords || valuesStart + totalDuration + 3 * static_cast<uint64_t>(record.nChords) > dataEnd)
+        return false;
+
+    const auto read = [&p](const uint32_t n) {
+        vector<int> values(n);
+        for (uint32_t i = 0; i < n; i++)
+            values[i] = static_cast<int8_t>(*p++);
+        return values;
+    };
+    solution.degrees.clear();
+    for (const auto d : durations)
+        solution.degrees.push_back(read(d));
+    solution.states     = read(record.nChords);
+    solution.qualities  = read(record.nChords);
+    solution.rootNotes  = read(record.nChords);
+    solution.cost       = record.cost;
+
+    const int interval = params.get_tonality(0)->get_tonic() - record.tonic;
+    for (auto& note : solution.rootNotes)
+        note = ((note + interval) % PERFECT_OCTAVE + PERFECT_OCTAVE) % PERFECT_OCTAVE;
+    return true;
+}
+
+/**
+ * Adds the solution of a piece to the store, unless the piece is already in it.
+ * @param params the parameters of the piece
+ * @param options the search options the solution was found with
+ * @param solution the solution
+ * @return false if the store is full, true otherwise
+ */
+bool SolutionStore::insert(const TonalPieceParameters& params, const HarmoniserOptions& options,
+                           const HarmoniserSolution& solution) {
+    if (!writable)
+        throw std::runtime_error("The solution store is read only");
+    const string key = SolutionCache::canonical_key(params, options);
+    const uint64_t hash = fnv1a(key);
+
+    RecordHeader record{};
+    record.keyLength        = static_cast<uint32_t>(key.size());
+    record.nChords          = static_cast<uint32_t>(solution.states.size());
+    record.nProgressions    = static_cast<uint32_t>(solution.degrees.size());
+    record.cost             = solution.cost;
+    record.tonic            = params.get_tonality(0)->get_tonic();
+    uint64_t size = sizeof(record) + key.size() + record.nProgressions * sizeof(uint32_t) + 3 * record.nChords;
+    for (const auto& d : solution.degrees)
+        size += d.size();
+    size = (size + 7) & ~static_cast<uint64_t>(7);     /// the records are aligned on 8 bytes
+
+    /// the file lock does not exclude the threads of this process, which share the file descriptor
+    std::lock_guard<std::mutex> threadLock(mutex);
+    FileLock lock(fd, LOCK_EX);
+    uint64_t existing;
+    const int64_t i = find(key, hash, existing);
+    if (existing != 0)
+        return true;
+    auto header = reinterpret_cast<StoreHeader*>(data);
+    if (i < 0 || header->dataEnd + size > header->fileSize)
+        return false;
+
+    /// write the record, then publish it in its bucket
+    const uint64_t offset = header->dataEnd;
+    uint8_t* p = data + offset;
+    std::memcpy(p, &record, sizeof(record));                p += sizeof(record);
+    std::memcpy(p, key.data(), key.size());                 p += key.size();
+    for (const auto& d : solution.degrees) {
+        const auto n = static_cast<uint32_t>(d.size());
+        std::memcpy(p, &n, sizeof(n));                      p += sizeof(n);
+    }
+    const auto write = [&p](const vector<int>& values) {
+        for (const int v : values)
+            *p++ = static_cast<uint8_t>(static_cast<int8_t>(v));
+    };
+    for (const auto& d : solution.degrees)
+        write(d);
+    write(solution.states);
+    write(solution.qualities);
+    write(solution.rootNotes);
+
+    /// the end of the data covers the record before it is published, so that the readers can check its bounds
+    __atomic_store_n(&header->dataEnd, offset + size, __ATOMIC_RELEASE);
+    uint64_t* b = bucket(static_cast<uint64_t>(i));
+    b[0] = hash;
+    __atomic_store_n(&b[1], offset, __ATOMIC_RELEASE);
+    __atomic_store_n(&header->nRecords, header->nRecords + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * Returns the number of solutions in the store
+ * @return the number of records
+ */
+uint64_t SolutionStore::size() const {
+    return __atomic_load_n(&reinterpret_cast<const StoreHeader*>(data)->nRecords, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,135 @@
+//
+// Created on 16/10/2026.
+//
+
+#include "../headers/TemplatePool.hpp"
+#include "../headers/TonalityRegistry.hpp"
+
+/**
+ * Constructor
+ * @param capacity the maximal number of templates in the pool
+ */
+TemplatePool::TemplatePool(const size_t capacity) : capacity(capacity), hits(0), misses(0) {
+    if (capacity == 0)
+        throw std::invalid_argument("The capacity of the pool must be positive");
+}
+
+/**
+ * Returns the structural key of a piece: its size, the tonic and mode of each tonality, the type, start and end of
+ * each modulation, the soft rules and the model options. The pieces with the same key have the same model.
+ * @param params the parameters of the piece
+ * @return the structural key
+ */
+string TemplatePool::structural_key(const TonalPieceParameters& params) {
+    string key = to_string(params.get_size()) + "|";
+    for (int i = 0; i < params.get_nProgressions(); i++)
+        key += to_string(params.get_tonality(i)->get_mode()) + ":" + to_string(params.get_tonality(i)->get_tonic()) + ",";
+    key += "|";
+    for (int i = 0; i < params.get_nProgressions() - 1; i++)
+        key += to_string(params.get_modulationType(i)) + ":" + to_string(params.get_modulationStart(i)) + ":" +
+               to_string(params.get_modulationEnd(i)) + ",";
+    key += "|";
+    for (const auto& rule : params.get_softRules())
+        key += to_string(rule.type) + ":" + to_string(rule.weight) + ":" + to_string(rule.degree) + ":" +
+               to_string(rule.state) + ",";
+    const ModelOptions& model = params.get_modelOptions();
+    key += "|" + to_string(model.tableModel) + to_string(model.transitionAutomaton) +
+           to_string(model.voiceLeadingPropagator) + to_string(model.leanSpace);
+    return key;
+}
+
+/**
+ * Builds the template of a structure. The parameters are copied with the tonalities of the registry, so that the
+ * template does not depend on the objects of the request that created it.
+ * @param params the parameters of the piece
+ * @param key the structural key of the parameters
+ * @return the template
+ */
+std::shared_ptr<TemplatePool::Template> TemplatePool::build(const TonalPieceParameters& params, string key) {
+    vector<Tonality*> tonalities;
+    vector<int> modulationTypes, modulationStarts, modulationEnds;
+    for (int i = 0; i < params.get_nProgressions(); i++)
+        tonalities.push_back(TonalityRegistry::get(params.get_tonality(i)->get_tonic(),
+                                                   params.get_tonality(i)->get_mode()));
+    for (int i = 0; i < params.get_nProgressions() - 1; i++) {
+        modulationTypes.push_back(params.get_modulationType(i));
+        modulationStarts.push_back(params.get_modulationStart(i));
+        modulationEnds.push_back(params.get_modulationEnd(i));
+    }
+
+    auto entry = std::make_shared<Template>();
+    entry->key = std::move(key);
+    entry->parameters.reset(new TonalPieceParameters(params.get_size(), params.get_nProgressions(), tonalities,
+                                                     modulationTypes, modulationStarts, modulationEnds));
+    entry->parameters->set_modelOptions(params.get_modelOptions());
+    for (const auto& rule : params.get_softRules())
+        entry->parameters->add_softRule(rule);
+
+    entry->root.reset(new TonalPiece(entry->parameters.get(), false));
+    if (entry->root->status() == SS_FAILED)
+        entry->root.reset();
+    return entry;
+}
+
+/**
+ * Returns a propagated piece for the parameters, cloned from the template of their structure. The template is built
+ * the first time the structure is requested. The piece has no branching and uses the default seed.
+ * @param params the parameters of the piece, they must outlive the piece
+ * @return the piece, owned by the caller, or nullptr if the model of the piece fails at the root
+ */
+TonalPiece* TemplatePool::acquire(TonalPieceParameters* params) {
+    string key = structural_key(*params);
+    std::shared_ptr<Template> entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = index.find(key);
+        if (it != index.end()) {
+            hits++;
+            templates.splice(templates.begin(), templates, it->second);     /// most recently used
+            entry = templates.front();
+        }
+    }
+    if (entry == nullptr) {
+        /// the model is built outside of the lock, if two threads build the same template only the first one is kept
+        auto built = build(*params, key);
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = index.find(key);
+        if (it != index.end()) {
+            hits++;
+            entry = *it->second;
+        }
+        else {
+            misses++;
+            if (templates.size() >= capacity) {
+                index.erase(templates.back()->key);
+                templates.pop_back();
+            }
+            templates.push_front(built);
+            index.emplace(std::move(key), templates.begin());
+            entry = std::move(built);
+        }
+    }
+
+    /// the template stays alive while it is cloned even if it is evicted meanwhile
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    if (entry->root == nullptr)
+        return nullptr;
+    const auto piece = static_cast<TonalPiece*>(entry->root->clone());
+    piece->set_parameters(params);
+    return piece;
+}
+
+size_t TemplatePool::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return templates.size();
+}
+
+unsigned long TemplatePool::get_hits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+}
+
+unsigned long TemplatePool::get_misses() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+}
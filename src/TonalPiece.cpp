@@ -4,27 +4,37 @@
 
 #include "../headers/TonalPiece.hpp"
 
+#include <random>
+
 /**
  * Constructor for TonalPiece objects.
  * It initializes the variable arrays, and links the auxiliary array to the main ones. Assuming the parameters are
  * correct, it computes the starting position and duration of each tonality, and creates the ChordProgression and
- * Modulation objects. It also posts the branching. It is done in this order: First, branch on the chord degrees
- * for each tonality, then branch on states and qualities if necessary.
+ * Modulation objects. It also posts the default branching (see post_branching), unless postBranching is false.
  * @param params a TonalPieceParameters object that contains the parameters for the piece
+ * @param postBranching whether to post the default branching, it can be posted later otherwise
+ * @param seed the seed of the random value selection of the branching (see set_seed)
  */
-TonalPiece:: TonalPiece(TonalPieceParameters* params) : parameters(params) {
+TonalPiece:: TonalPiece(TonalPieceParameters* params, const bool postBranching, const unsigned int seed) :
+    parameters(params), branching(-1), seed(seed), neighbourhood(0),
+    clones(std::make_shared<std::atomic<unsigned long>>(0)) {
 
     this->states                = IntVarArray(*this, params->get_size(), FUNDAMENTAL_STATE,   THIRD_INVERSION);
     this->qualities             = IntVarArray(*this, params->get_size(), MAJOR_CHORD,         MINOR_NINTH_DOMINANT_CHORD);
     this->rootNotes             = IntVarArray(*this, params->get_size(), C,                   B);
-    this->hasSeventh            = IntVarArray(*this, params->get_size(), 0,                   1);
-    this->qualitiesWithoutSeventh = IntVarArray(*this, params->get_size(), MAJOR_CHORD, AUGMENTED_CHORD);
 
-    ///constraint
-    link_qualities_to_3note_version(*this, params->get_size(), qualities, qualitiesWithoutSeventh);
+    if (params->get_modelOptions().leanSpace) {
+        /// the qualities are limited to the ones with a simple version, as the link below does in the full model
+        rel(*this, qualities, IRT_LE, nSimpleQualities);
+    }
+    else {
+        this->hasSeventh            = IntVarArray(*this, params->get_size(), 0,                   1);
+        this->qualitiesWithoutSeventh = IntVarArray(*this, params->get_size(), MAJOR_CHORD, AUGMENTED_CHORD);
+
+        ///constraint
+        link_qualities_to_3note_version(*this, params->get_size(), qualities, qualitiesWithoutSeventh);
+    }
 
-    //todo add control over states (% of fund state, % of inversions,...)
-    //todo add preference for state based on the chord degree (e.g. I should be often used in fund, sometimes 1st inversion, 2nd should be often in 1st inversion, ...)
     //todo add some measure of variety (number of chords used, max % of chord based on degree, ...)
     //todo add marche harmoniques (diatoniques/modulantes/chromatiques/par quinte/par quarte/...)
     //todo make an options object that has a field for every parameter
@@ -35,50 +45,239 @@ TonalPiece:: TonalPiece(TonalPieceParameters* params) : parameters(params) {
     progressions.reserve(params->get_nProgressions());    modulations.reserve(params->get_nProgressions() - 1);
     /// Create the ChordProgression objects for each section, and post the constraints
     for (int i = 0; i < params->get_nProgressions(); i++)
-        progressions.push_back(
-                new ChordProgression(*this, parameters->get_progressionStart(i), parameters->get_progressionDuration(i),
-                                     parameters->get_tonality(i), states, qualities,
-                                     qualitiesWithoutSeventh, rootNotes, hasSeventh,
-                                     0, 1,
-                                     0, 1)
-                );
+        progressions.emplace_back(*this, parameters->get_progressionStart(i), parameters->get_progressionDuration(i),
+                                  parameters->get_tonality(i), states, qualities,
+                                  qualitiesWithoutSeventh, rootNotes, hasSeventh,
+                                  0, 1,
+                                  0, 1, parameters->get_modelOptions());
 
     /// Create the Modulation objects for each modulation, and post the constraints
     for(int i = 0; i < params->get_nProgressions() - 1; i++)
-        modulations.push_back(
-        new Modulation(*this, parameters->get_modulationType(i), params->get_modulationStart(i), parameters->get_modulationEnd(i),
-                       progressions[i], progressions[i+1])
-        );
+        modulations.emplace_back(*this, parameters->get_modulationType(i), params->get_modulationStart(i),
+                                 parameters->get_modulationEnd(i), progressions[i], progressions[i+1]);
 
+    /// Post the soft rules (see SoftRule)
+    post_soft_rules();
 
-    /** The branching on chord degrees is performed first, through the ChordProgression objects. Then it is performed
-     * on state and quality if necessary.*/
-
-    const Rnd r(1U);
-    for(const auto p : progressions)
-        branch(*this, p->getChords(), INT_VAR_SIZE_MIN(), INT_VAL_RND(r));
-    branch(*this, states,       INT_VAR_SIZE_MIN(), INT_VAL_MIN());
-    branch(*this, qualities,    INT_VAR_SIZE_MIN(), INT_VAL_MIN());
+    if (postBranching)
+        post_branching(BRANCH_SIZE_RANDOM);
 }
 
 /**
  * @brief Copy constructor
  * @param s a ChordProgression object pointer
- * Returns a TonalPiece object that is equivalent to s
+ * Returns a TonalPiece object that is equivalent to s. The modulations only contain values, so they are copied as is.
  */
-TonalPiece::TonalPiece(TonalPiece &s) : Space(s){
+TonalPiece::TonalPiece(TonalPiece &s) : Space(s), modulations(s.modulations), clones(s.clones) {
+    clones->fetch_add(1, std::memory_order_relaxed);
     parameters                  = s.parameters;
+    branching                   = s.branching;
+    seed                        = s.seed;
+    neighbourhood               = s.neighbourhood;
     states                      .update(*this, s.states);
     qualities                   .update(*this, s.qualities);
     rootNotes                   .update(*this, s.rootNotes);
     hasSeventh                  .update(*this, s.hasSeventh);
     qualitiesWithoutSeventh       .update(*this, s.qualitiesWithoutSeventh);
+    cost                        .update(*this, s.cost);
+
+    progressions.reserve(s.progressions.size());
+    for (auto& p : s.progressions)
+        progressions.emplace_back(*this, p);
+}
+
+/**
+ * Posts the soft rules of the parameters, and links their violations to the cost of the piece.
+ */
+void TonalPiece::post_soft_rules() {
+    BoolVarArgs violations;
+    IntArgs weights;
+    int maxCost = 0;
+    for (const auto& rule : parameters->get_softRules()) {
+        switch (rule.type) {
+            /// every chord that is not in fundamental state
+            case INVERSION_SOFT_RULE:
+                for (int i = 0; i < states.size(); i++)
+                    violations << expr(*this, states[i] != FUNDAMENTAL_STATE);
+                break;
+            /// every chord of the given degree that is not in the preferred state, in each tonality
+            case PREFERRED_STATE_SOFT_RULE:
+                for (auto& p : progressions)
+                    for (int i = 0; i < p.getDuration(); i++)
+                        violations << expr(*this, p.getChords()[i] == rule.degree &&
+                                                  p.getStates()[i] != rule.state);
+                break;
+            /// every chord with the same degree as the previous one, in each tonality
+            case REPEATED_DEGREE_SOFT_RULE:
+                for (auto& p : progressions)
+                    for (int i = 0; i < p.getDuration() - 1; i++)
+                        violations << expr(*this, p.getChords()[i] == p.getChords()[i+1]);
+                break;
+            /// every chord with a seventh
+            case SEVENTH_CHORD_SOFT_RULE:
+                for (int i = 0; i < qualities.size(); i++)
+                    violations << expr(*this, qualities[i] >= DOMINANT_SEVENTH_CHORD);
+                break;
+            default:
+                throw std::invalid_argument("Invalid soft rule type");
+        }
+        while (weights.size() < violations.size()) {
+            weights << rule.weight;
+            maxCost += rule.weight;
+        }
+    }
+    cost = IntVar(*this, 0, maxCost);
+    linear(*this, weights, violations, IRT_EQ, cost);
+}
+
+/**
+ * Constrains the cost of the piece to be strictly lower than the cost of the best solution found so far. It is
+ * called by the branch and bound search engines.
+ * @param best the best solution found so far
+ */
+void TonalPiece::constrain(const Space& best) {
+    rel(*this, cost, IRT_LE, static_cast<const TonalPiece&>(best).cost.val());
+}
+
+/**
+ * Posts the branching. It is done in this order: First, branch on the chord degrees for each tonality with the
+ * given strategy, then branch on states and qualities if necessary. The branching can only be posted once.
+ * @param strategy a BranchingStrategy
+ */
+void TonalPiece::post_branching(const int strategy) {
+    if (branching >= 0)
+        throw std::invalid_argument("The branching of the piece is already posted");
+    if (strategy < 0 || strategy >= N_BRANCHING_STRATEGIES)
+        throw std::invalid_argument("Invalid branching strategy");
+    branching = strategy;
+
+    /** The branching on chord degrees is performed first, through the ChordProgression objects. Then it is performed
+     * on state and quality if necessary.*/
+    const Rnd r(seed);
+    for(auto& p : progressions) {
+        switch (strategy) {
+            case BRANCH_SIZE_RANDOM:
+                branch(*this, p.getChords(), INT_VAR_SIZE_MIN(), INT_VAL_RND(r));
+                break;
+            case BRANCH_AFC_RANDOM:
+                branch(*this, p.getChords(), INT_VAR_AFC_SIZE_MAX(0.99), INT_VAL_RND(r));
+                break;
+            case BRANCH_INPUT_ORDER_MIN:
+                branch(*this, p.getChords(), INT_VAR_NONE(), INT_VAL_MIN());
+                break;
+            case BRANCH_DEGREE_SPLIT:
+                branch(*this, p.getChords(), INT_VAR_DEGREE_SIZE_MAX(), INT_VAL_SPLIT_MIN());
+                break;
+            default:
+                break;
+        }
+    }
+    branch(*this, states,       INT_VAR_SIZE_MIN(), INT_VAL_MIN());
+    branch(*this, qualities,    INT_VAR_SIZE_MIN(), INT_VAL_MIN());
+}
+
+/**
+ * Called by the search engines on the copy of the space that they explore. In a portfolio, each asset posts a
+ * different branching strategy with a different seed. When restarting with a large neighbourhood, the incumbent
+ * solution is fixed outside of a window.
+ * @param mi the information about the restart or the portfolio asset
+ * @return false if only a neighbourhood is explored, true if the search in the slave is complete
+ */
+bool TonalPiece::slave(const MetaInfo& mi) {
+    if (mi.type() == MetaInfo::PORTFOLIO && !has_branching()) {
+        seed += mi.asset();
+        post_branching(static_cast<int>(mi.asset() % N_BRANCHING_STRATEGIES));
+    }
+    if (mi.type() == MetaInfo::RESTART && neighbourhood > 0 && mi.last() != nullptr) {
+        relax(static_cast<const TonalPiece&>(*mi.last()), mi.restart());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Fixes the chords of the incumbent solution outside of a window of the piece. The window is chosen at random among
+ * the NeighbourhoodType, and is at most neighbourhood chords long.
+ * @param incumbent the best solution found so far
+ * @param restart the number of the restart, used to draw the window
+ */
+void TonalPiece::relax(const TonalPiece& incumbent, const unsigned long restart) {
+    std::mt19937 rng(seed + static_cast<unsigned int>(restart));
+    const int size = parameters->get_size();
 
-    for (const auto p : s.progressions)
-        progressions.push_back(new ChordProgression(*this, *p));
+    /// the region of the piece the window is drawn from
+    int first = 0, last = size - 1;
+    int type = static_cast<int>(rng() % N_NEIGHBOURHOOD_TYPES);
+    if (type == MODULATION_WINDOW && modulations.empty())
+        type = RANDOM_WINDOW;
+    switch (type) {
+        case PHRASE_WINDOW: {
+            const int phrase = static_cast<int>(rng() % parameters->get_nProgressions());
+            first = parameters->get_phraseStart(phrase);    last = parameters->get_phraseEnd(phrase);
+            break;
+        }
+        case MODULATION_WINDOW: {   /// the modulation and the chords around it
+            const auto& m = modulations[rng() % modulations.size()];
+            first = std::max(0, m.getStart() - neighbourhood / 2);
+            last = std::min(size - 1, m.getEnd() + neighbourhood / 2);
+            break;
+        }
+        case PROGRESSION_WINDOW: {
+            const auto& p = progressions[rng() % progressions.size()];
+            first = p.getStart();   last = p.getStart() + p.getDuration() - 1;
+            break;
+        }
+        default:
+            break;
+    }
+    /// a window of at most neighbourhood chords inside the region
+    const int length = std::min(neighbourhood, last - first + 1);
+    first += static_cast<int>(rng() % (last - first + 2 - length));
+    last = first + length - 1;
 
-    for (const auto m : s.modulations)
-        modulations.push_back(new Modulation(*this, *m));
+    /// fix everything outside of the window
+    for (size_t k = 0; k < progressions.size(); k++) {
+        const int start = progressions[k].getStart();
+        for (int i = 0; i < progressions[k].getDuration(); i++)
+            if (start + i < first || start + i > last)
+                rel(*this, progressions[k].getChords()[i], IRT_EQ, incumbent.progressions[k].getChords()[i].val());
+    }
+    for (int i = 0; i < size; i++) {
+        if (i >= first && i <= last)
+            continue;
+        rel(*this, states[i],    IRT_EQ, incumbent.states[i].val());
+        rel(*this, qualities[i], IRT_EQ, incumbent.qualities[i].val());
+    }
+}
+
+/**
+ * Fixes the chords of a solution outside of the given windows. The windows are left free, so that a search only has
+ * to find their chords, e.g. to join solutions of parts of the piece.
+ * @param degrees the chord degrees of each progression
+ * @param states the state of each chord of the piece
+ * @param qualities the quality of each chord of the piece
+ * @param windows the first and last positions of each window that stays free
+ */
+void TonalPiece::fix(const vector<vector<int>>& degrees, const vector<int>& states, const vector<int>& qualities,
+                     const vector<std::pair<int, int>>& windows) {
+    const auto is_free = [&windows](const int position) {
+        for (const auto& [first, last] : windows)
+            if (position >= first && position <= last)
+                return true;
+        return false;
+    };
+    for (size_t k = 0; k < progressions.size(); k++) {
+        const int start = progressions[k].getStart();
+        for (int i = 0; i < progressions[k].getDuration(); i++)
+            if (!is_free(start + i))
+                rel(*this, progressions[k].getChords()[i], IRT_EQ, degrees[k][i]);
+    }
+    for (int i = 0; i < parameters->get_size(); i++) {
+        if (is_free(i))
+            continue;
+        rel(*this, this->states[i],    IRT_EQ, states[i]);
+        rel(*this, this->qualities[i], IRT_EQ, qualities[i]);
+    }
 }
 
 /**
@@ -93,14 +292,26 @@ string TonalPiece::toString() const {
 
     txt += "States:\t\t\t"                  + intVarArray_to_string(states)                         + "\n";
     txt += "Qualities:\t\t"                 + intVarArray_to_string(qualities)                      + "\n";
-    txt += "Quality (no seventh):\t"        + intVarArray_to_string(qualitiesWithoutSeventh)        + "\n";
+    /// in lean mode, the auxiliary arrays of the piece are computed from the qualities, the only values they depend on
+    const auto auxiliary = [this](const IntVarArray& vars, const ChordValue value) {
+        if (!parameters->get_modelOptions().leanSpace)
+            return intVarArray_to_string(vars);
+        if (!qualities.assigned())
+            return string("?");
+        vector<int> values;
+        for (const auto& q : qualities)
+            values.push_back(value(FIRST_DEGREE, FUNDAMENTAL_STATE, q.val()));
+        return int_vector_to_string(values);
+    };
+    txt += "Quality (no seventh):\t"        + auxiliary(qualitiesWithoutSeventh, chord_quality_without_seventh) + "\n";
     txt += "Root notes:\t\t"                + intVarArray_to_string(rootNotes)                      + "\n";
-    txt += "Has seventh:\t\t"               + intVarArray_to_string(hasSeventh)                     + "\n";
+    txt += "Has seventh:\t\t"               + auxiliary(hasSeventh, chord_has_seventh)               + "\n";
+    txt += "Cost:\t\t\t"                    + (cost.assigned() ? to_string(cost.val()) : string("?"))  + "\n";
 
     txt += "\nChord Progressions for each tonality:\n";
-    for(auto p : progressions)      txt += p->toString()                                    + "\n\n";
+    for(const auto& p : progressions)   txt += p.toString()                                 + "\n\n";
     txt += "\nModulations:\n";
-    for(auto m : modulations)            txt += m->toString()                                    + "\n\n";
+    for(const auto& m : modulations)    txt += m.toString()                                 + "\n\n";
 
     return txt;
 }
@@ -113,14 +324,24 @@ string TonalPiece::toString() const {
 string TonalPiece::pretty() const {
     string txt;
     for(int i = 0; i < progressions.size(); i++){
-        txt += progressions[i]->pretty() + "\n";
+        txt += progressions[i].pretty() + "\n";
         if(i < modulations.size())
-            txt += modulations[i]->pretty() + "\n";
+            txt += modulations[i].pretty() + "\n";
         txt += "\n";
     }
     return txt;
 }
 
+/**
+ * Returns the number of bytes used by a clone of this space: the memory allocated by Gecode for the variables and
+ * propagators, the object itself and the arrays of progressions and modulations.
+ * @return the size of a clone in bytes
+ */
+size_t TonalPiece::clone_size() const {
+    return allocated() + sizeof(TonalPiece) + progressions.capacity() * sizeof(ChordProgression) +
+           modulations.capacity() * sizeof(Modulation);
+}
+
 /**
  * @brief copy function
  * @return a Space* object that is a copy of the current object
@@ -93,6 +93,22 @@ TonalPieceParameters::TonalPieceParameters(const int nChords, const int nSection
     phraseEnds.push_back(nChords-1);
 }
 
+/**
+ * Adds a weighted soft rule to the piece. The rules are posted when the TonalPiece is created.
+ * @param rule a SoftRule
+ */
+void TonalPieceParameters::add_softRule(const SoftRule& rule) {
+    if (rule.type < 0 || rule.type >= N_SOFT_RULE_TYPES)
+        throw std::invalid_argument("Invalid soft rule type");
+    if (rule.weight <= 0)
+        throw std::invalid_argument("The weight of a soft rule must be positive");
+    if (rule.type == PREFERRED_STATE_SOFT_RULE &&
+        (rule.degree < FIRST_DEGREE || rule.degree > AUGMENTED_SIXTH ||
+         rule.state < FUNDAMENTAL_STATE || rule.state > THIRD_INVERSION))
+        throw std::invalid_argument("A preferred state rule needs a valid degree and state");
+    softRules.push_back(rule);
+}
+
 /**
  * ToString method
  * Prints the total number of chords in the piece, the tonality of each section, the modulations' type, start and end
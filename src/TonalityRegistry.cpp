@@ -0,0 +1,122 @@
+//
+// Created on 16/10/2026.
+//
+
+#include "../headers/TonalityRegistry.hpp"
+#include "../headers/Constraints.hpp"
+
+#include <algorithm>
+
+/**
+ * Computes all the tables derived from a tonality
+ * @param tonality the tonality
+ * @return the tables of the tonality
+ */
+static std::unique_ptr<TonalityTables> build_tonality_tables(Tonality* tonality) {
+    std::unique_ptr<TonalityTables> tables(new TonalityTables());
+    tables->tonality = tonality;
+
+    /// The root note of each degree
+    vector<int> degreeNotes;        degreeNotes.reserve(nSupportedChords);
+    for (int i = FIRST_DEGREE; i <= AUGMENTED_SIXTH; i++)
+        degreeNotes.push_back(tonality->get_degree_note(i));
+    tables->degreeNotes = IntArgs(degreeNotes);
+
+    tables->degreeQualities = tonality->get_mode() == MAJOR_MODE ? &majorDegreeQualities : &minorDegreeQualities;
+
+    /// The diatonic notes followed by the other notes, which get a fake degree above the seventh degree. The qualities of
+    /// the fake degrees are -1. noteToDegree is the inverse of alterationNotes.
+    vector<int> alterationNotes;        alterationNotes.reserve(PERFECT_OCTAVE);
+    vector<int> alterationQualities;    alterationQualities.reserve(PERFECT_OCTAVE);
+    for (int i = FIRST_DEGREE; i <= SEVENTH_DEGREE; i++) {
+        alterationNotes.push_back(tonality->get_degree_note(i));
+        alterationQualities.push_back(tonality->get_chord_quality(i));
+    }
+    for (int note = C; note <= B; note++) {
+        if (std::find(alterationNotes.begin(), alterationNotes.end(), note) == alterationNotes.end()) {
+            alterationNotes.push_back(note);
+            alterationQualities.push_back(-1);
+        }
+    }
+    vector<int> noteToDegree(PERFECT_OCTAVE);
+    for (int i = 0; i < PERFECT_OCTAVE; i++)
+        noteToDegree[alterationNotes[i]] = i;
+    tables->alterationNotes = IntArgs(alterationNotes);
+    tables->alterationQualities = IntArgs(alterationQualities);
+    tables->noteToDegree = IntArgs(noteToDegree);
+
+    tables->chordTable = build_chord_table(tonality);
+    tables->leanChordTable = build_chord_table(tonality, true);
+    tables->transitionsAutomaton = build_chord_transitions_automaton(tonality->get_mode());
+
+    /// The legal chords and their successions, for the solvers working without Gecode (see SolutionCounter and BitsetSolver)
+    for (int degree = FIRST_DEGREE; degree <= AUGMENTED_SIXTH; degree++)
+        for (int state = FUNDAMENTAL_STATE; state <= THIRD_INVERSION; state++)
+            for (int quality = MAJOR_CHORD; quality < nSimpleQualities; quality++)
+                if (is_legal_chord(tonality, degree, state, quality))
+                    tables->chords.push_back({degree, state, quality});
+    const size_t nChords = tables->chords.size();
+    tables->successors.resize(nChords);     tables->sameDegree.resize(nChords);
+    for (size_t a = 0; a < nChords; a++) {
+        const auto& [degree, state, quality] = tables->chords[a];
+        for (size_t b = 0; b < nChords; b++) {
+            const auto& [nextDegree, nextState, nextQuality] = tables->chords[b];
+            if (is_legal_succession(degree, state, quality, nextDegree, nextState, nextQuality))
+                tables->successors[a].set(b);
+            if (degree == nextDegree)
+                tables->sameDegree[a].set(b);
+        }
+    }
+    return tables;
+}
+
+/**
+ * Creates the 24 tonalities and computes their tables
+ */
+TonalityRegistry::TonalityRegistry() {
+    for (int tonic = C; tonic <= B; tonic++) {
+        majorTonalities[tonic].reset(new MajorTonality(tonic));
+        minorTonalities[tonic].reset(new MinorTonality(tonic));
+        tables[MAJOR_MODE][tonic] = build_tonality_tables(majorTonalities[tonic].get());
+        tables[MINOR_MODE][tonic] = build_tonality_tables(minorTonalities[tonic].get());
+    }
+}
+
+/**
+ * Returns the only instance of the registry. It is created the first time this function is called, which is thread safe.
+ * @return the registry
+ */
+const TonalityRegistry& TonalityRegistry::instance() {
+    static const TonalityRegistry registry;
+    return registry;
+}
+
+/**
+ * Returns the tonality with the given tonic and mode from the registry
+ * @param tonic the tonic of the tonality
+ * @param mode the mode of the tonality (MAJOR_MODE or MINOR_MODE)
+ * @return the shared tonality object
+ */
+Tonality* TonalityRegistry::get(const int tonic, const int mode) {
+    if (tonic < C || tonic > B)
+        throw std::invalid_argument("The tonic must be a note between C and B");
+    if (mode == MAJOR_MODE)
+        return instance().majorTonalities[tonic].get();
+    if (mode == MINOR_MODE)
+        return instance().minorTonalities[tonic].get();
+    throw std::invalid_argument("The mode must be MAJOR_MODE or MINOR_MODE");
+}
+
+/**
+ * Returns the tables derived from a tonality. The tonality does not need to come from the registry, the tables are
+ * found from its tonic and mode.
+ * @param tonality a tonality
+ * @return the shared tables of the tonality
+ */
+const TonalityTables& TonalityRegistry::get_tables(const Tonality* tonality) {
+    const int tonic = tonality->get_tonic() % PERFECT_OCTAVE;
+    const int mode = tonality->get_mode();
+    if (mode != MAJOR_MODE && mode != MINOR_MODE)
+        throw std::invalid_argument("The mode must be MAJOR_MODE or MINOR_MODE");
+    return *instance().tables[mode][tonic];
+}
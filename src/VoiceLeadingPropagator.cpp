@@ -0,0 +1,389 @@
+//
+// Created on 16/10/2026.
+//
+
+#include "../headers/Constraints.hpp"
+
+using namespace Gecode::Int;
+
+/**
+ * Returns the degree of the note at the bass of a chord, or of one of its notes when state is a fixed inversion.
+ * @param degree the degree of the chord
+ * @param state the state of the chord
+ * @return the degree of the bass note
+ */
+static int bass_of(const int degree, const int state) {
+    return bassBasedOnDegreeAndStateMatrix[degree * nSupportedStates + state];
+}
+
+/**
+ * Whether the chord is a dominant chord that has to resolve its tritone (same formula as in tritone_resolutions)
+ * @param degree the degree of the chord
+ * @param quality the quality of the chord
+ * @return true if the chord is a dominant chord
+ */
+static bool is_dominant(const int degree, const int quality) {
+    return (degree == FIFTH_DEGREE && (quality == MAJOR_CHORD || quality == DOMINANT_SEVENTH_CHORD ||
+                                       quality == DIMINISHED_SEVENTH_CHORD)) ||
+           (FIVE_OF_TWO <= degree && degree <= FIVE_OF_SEVEN);
+}
+
+/**
+ * Whether the seventh of the chord must be prepared (same condition as in seventh_chords_preparation)
+ * @param degree the degree of the chord
+ * @param quality the quality of the chord
+ * @return true if the seventh must be present in the previous chord
+ */
+static bool needs_preparation(const int degree, const int quality) {
+    return quality >= DOMINANT_SEVENTH_CHORD && quality != DOMINANT_SEVENTH_CHORD && degree <= SEVENTH_DEGREE;
+}
+
+/**
+ * Whether the seventh of a chord is the root, the third or the fifth of the previous chord
+ * @param previous the degree of the previous chord
+ * @param degree the degree of the chord
+ * @return true if the seventh of the chord is prepared by the previous chord
+ */
+static bool is_prepared(const int previous, const int degree) {
+    const int stateInPrevious = statesByBassMatrix[previous * 7 + bass_of(degree, THIRD_INVERSION)];
+    return stateInPrevious >= FUNDAMENTAL_STATE && stateInPrevious <= SECOND_INVERSION;
+}
+
+/**
+ * The bass degree required after a dominant chord in the given state and with the given bass, or -1 if there is no
+ * requirement. The modulo has the same semantics as the one in tritone_resolutions, so that V/V in third inversion
+ * (whose bass is the first degree) cannot be resolved.
+ * @param dominant whether the chord is a dominant chord
+ * @param state the state of the chord
+ * @param bass the bass degree of the chord
+ * @return the bass degree of the next chord, -1 if it is free, or -2 if no bass degree can resolve the chord
+ */
+static int required_next_bass(const bool dominant, const int state, const int bass) {
+    if (!dominant)
+        return -1;
+    if (state == FIRST_INVERSION)       /// 65/ -> 5
+        return (bass + 1) % 7;
+    if (state == THIRD_INVERSION)       /// +4 -> 6
+        return (bass - 1) % 7 < 0 ? -2 : (bass - 1) % 7;
+    return -1;
+}
+
+/**
+ * Advisor attached to one variable of the propagator. It remembers the position of the chord it belongs to, and which
+ * of the arrays the variable comes from, so that it can be cancelled when the propagator is disposed.
+ */
+class ChordAdvisor : public Advisor {
+public:
+    int position;       /// the position of the chord in the progression
+    int array;          /// 0 for the chords, 1 for the states, 2 for the qualities
+
+    ChordAdvisor(Space& home, Propagator& p, Council<ChordAdvisor>& c, const int position, const int array) :
+        Advisor(home, p, c), position(position), array(array) {}
+
+    ChordAdvisor(Space& home, ChordAdvisor& a) : Advisor(home, a), position(a.position), array(a.array) {}
+};
+
+/**
+ * Propagator for the rules of tonal harmony on one chord or two successive chords that are decomposed into reified
+ * expressions otherwise (tritone_resolutions, seventh_chords_preparation and diminished_seventh_dominant_chords).
+ * Advisors record which chords were modified, and only the windows (i-1, i), (i) and (i, i+1) around these chords are
+ * filtered again. Each rule is made domain consistent on its own by looking for a support for every value.
+ */
+class VoiceLeadingRules : public Propagator {
+protected:
+    ViewArray<IntView> chords;              /// the degrees of the chords
+    ViewArray<IntView> states;              /// the states of the chords
+    ViewArray<IntView> qualities;           /// the qualities of the chords
+    Council<ChordAdvisor> council;          /// the advisors of the variables
+
+    int* modified;                          /// stack of the positions to filter again
+    bool* isModified;                       /// whether each position is in the stack
+    int nModified;                          /// the size of the stack
+    int nUnassigned;                        /// the number of variables that are not assigned yet
+
+    /**
+     * Pushes a position on the stack of modified positions if it is not there yet
+     * @param position the position of the chord
+     */
+    void mark(const int position) {
+        if (!isModified[position]) {
+            isModified[position] = true;
+            modified[nModified++] = position;
+        }
+    }
+
+    /**
+     * Removes the values of a variable that have no support
+     * @param home the space
+     * @param view the variable
+     * @param supported whether each value from 0 has a support
+     * @param nValues the number of values in supported
+     * @param position the position of the chord, marked if the variable is modified
+     * @return ES_FAILED if the domain becomes empty, ES_OK otherwise
+     */
+    ExecStatus prune(Space& home, IntView& view, const bool* supported, const int nValues, const int position) {
+        for (int v = 0; v < nValues; v++) {
+            if (supported[v] || !view.in(v))
+                continue;
+            const ModEvent me = view.nq(home, v);
+            if (me_failed(me))
+                return ES_FAILED;
+            mark(position);
+        }
+        return ES_OK;
+    }
+
+    /**
+     * Diminished seventh chords must be in first inversion, except on the seventh degree
+     * formula: qualities[i] == DIMINISHED_SEVENTH_CHORD && chords[i] != SEVENTH_DEGREE => states[i] == FIRST_INVERSION
+     * @param home the space
+     * @param i the position of the chord
+     * @return the status of the filtering
+     */
+    ExecStatus single_chord(Space& home, const int i) {
+        bool degreeSupport[nSupportedChords] = {};      bool stateSupport[nSupportedStates] = {};
+        bool qualitySupport[nSupportedQualities] = {};
+        for (int c = 0; c < nSupportedChords; c++) {
+            if (!chords[i].in(c)) continue;
+            for (int q = 0; q < nSupportedQualities; q++) {
+                if (!qualities[i].in(q)) continue;
+                for (int s = 0; s < nSupportedStates; s++) {
+                    if (!states[i].in(s)) continue;
+                    if (q == DIMINISHED_SEVENTH_CHORD && c != SEVENTH_DEGREE && s != FIRST_INVERSION) continue;
+                    degreeSupport[c] = qualitySupport[q] = stateSupport[s] = true;
+                }
+            }
+        }
+        GECODE_ES_CHECK(prune(home, chords[i],    degreeSupport,  nSupportedChords,     i));
+        GECODE_ES_CHECK(prune(home, qualities[i], qualitySupport, nSupportedQualities,  i));
+        GECODE_ES_CHECK(prune(home, states[i],    stateSupport,   nSupportedStates,     i));
+        return ES_OK;
+    }
+
+    /**
+     * Tritone resolutions and preparation of the seventh between the chords at positions i and i+1
+     * formula: dominant(i) && states[i] == FIRST_INVERSION => bass(i+1) == (bass(i) + 1) % 7
+     * formula: dominant(i) && states[i] == THIRD_INVERSION => bass(i+1) == (bass(i) - 1) % 7
+     * formula: needs_preparation(i+1) => is_prepared(chords[i], chords[i+1])
+     * @param home the space
+     * @param i the position of the first chord of the window
+     * @return the status of the filtering
+     */
+    ExecStatus successive_chords(Space& home, const int i) {
+        const int j = i + 1;
+        bool degreeSupport[nSupportedChords] = {};      bool stateSupport[nSupportedStates] = {};
+        bool qualitySupport[nSupportedQualities] = {};
+        bool nextDegreeSupport[nSupportedChords] = {};  bool nextStateSupport[nSupportedStates] = {};
+
+        /// bass degrees that the next chord can have
+        bool nextBass[7] = {};
+        for (int c = 0; c < nSupportedChords; c++)
+            if (chords[j].in(c))
+                for (int s = 0; s < nSupportedStates; s++)
+                    if (states[j].in(s))
+                        nextBass[bass_of(c, s)] = true;
+
+        /// tritone resolutions: supports for the first chord, and bass degrees that the first chord allows for the next
+        bool anyNextBass = false;           bool allowedNextBass[7] = {};
+        for (int c = 0; c < nSupportedChords; c++) {
+            if (!chords[i].in(c)) continue;
+            for (int q = 0; q < nSupportedQualities; q++) {
+                if (!qualities[i].in(q)) continue;
+                for (int s = 0; s < nSupportedStates; s++) {
+                    if (!states[i].in(s)) continue;
+                    const int required = required_next_bass(is_dominant(c, q), s, bass_of(c, s));
+                    if (required == -2 || (required >= 0 && !nextBass[required])) continue;
+                    degreeSupport[c] = qualitySupport[q] = stateSupport[s] = true;
+                    if (required == -1) anyNextBass = true;
+                    else allowedNextBass[required] = true;
+                }
+            }
+        }
+        GECODE_ES_CHECK(prune(home, chords[i],    degreeSupport,  nSupportedChords,     i));
+        GECODE_ES_CHECK(prune(home, qualities[i], qualitySupport, nSupportedQualities,  i));
+        GECODE_ES_CHECK(prune(home, states[i],    stateSupport,   nSupportedStates,     i));
+        for (int c = 0; c < nSupportedChords; c++)
+            if (chords[j].in(c))
+                for (int s = 0; s < nSupportedStates; s++)
+                    if (states[j].in(s) && (anyNextBass || allowedNextBass[bass_of(c, s)]))
+                        nextDegreeSupport[c] = nextStateSupport[s] = true;
+        GECODE_ES_CHECK(prune(home, chords[j],    nextDegreeSupport, nSupportedChords,  j));
+        GECODE_ES_CHECK(prune(home, states[j],    nextStateSupport,  nSupportedStates,  j));
+
+        /// preparation of the seventh of the second chord by the first one
+        bool previousSupport[nSupportedChords] = {};    bool nextQualitySupport[nSupportedQualities] = {};
+        for (int c = 0; c < nSupportedChords; c++) nextDegreeSupport[c] = false;
+        bool anyPrevious = false;
+        for (int c = 0; c < nSupportedChords; c++) {
+            if (!chords[j].in(c)) continue;
+            for (int q = 0; q < nSupportedQualities; q++) {
+                if (!qualities[j].in(q)) continue;
+                if (!needs_preparation(c, q)) {
+                    nextDegreeSupport[c] = nextQualitySupport[q] = anyPrevious = true;
+                    continue;
+                }
+                for (int p = 0; p < nSupportedChords; p++) {
+                    if (!chords[i].in(p) || !is_prepared(p, c)) continue;
+                    nextDegreeSupport[c] = nextQualitySupport[q] = previousSupport[p] = true;
+                }
+            }
+        }
+        if (anyPrevious)
+            for (int p = 0; p < nSupportedChords; p++) previousSupport[p] = true;
+        GECODE_ES_CHECK(prune(home, chords[j],    nextDegreeSupport,  nSupportedChords,    j));
+        GECODE_ES_CHECK(prune(home, qualities[j], nextQualitySupport, nSupportedQualities, j));
+        GECODE_ES_CHECK(prune(home, chords[i],    previousSupport,    nSupportedChords,    i));
+        return ES_OK;
+    }
+
+public:
+    /**
+     * Constructor. Subscribes an advisor to every variable, and marks all the positions to be filtered.
+     * @param home the space
+     * @param c the degrees of the chords
+     * @param s the states of the chords
+     * @param q the qualities of the chords
+     */
+    VoiceLeadingRules(Home home, ViewArray<IntView>& c, ViewArray<IntView>& s, ViewArray<IntView>& q) :
+        Propagator(home), chords(c), states(s), qualities(q), council(home) {
+        const int n = chords.size();
+        Space& space = home;
+        modified = space.alloc<int>(n);     isModified = space.alloc<bool>(n);
+        nModified = 0;                      nUnassigned = 0;
+        for (int i = 0; i < n; i++) {
+            isModified[i] = false;
+            mark(i);
+            chords[i]   .subscribe(home, *new (home) ChordAdvisor(home, *this, council, i, 0));
+            states[i]   .subscribe(home, *new (home) ChordAdvisor(home, *this, council, i, 1));
+            qualities[i].subscribe(home, *new (home) ChordAdvisor(home, *this, council, i, 2));
+            nUnassigned += !chords[i].assigned() + !states[i].assigned() + !qualities[i].assigned();
+        }
+        IntView::schedule(home, *this, ME_INT_DOM);
+    }
+
+    /**
+     * Copy constructor. The propagator is at fixpoint when the space is cloned, but the stack is copied anyway.
+     * @param home the space
+     * @param p the propagator to copy
+     */
+    VoiceLeadingRules(Space& home, VoiceLeadingRules& p) : Propagator(home, p) {
+        chords      .update(home, p.chords);
+        states      .update(home, p.states);
+        qualities   .update(home, p.qualities);
+        council     .update(home, p.council);
+        const int n = chords.size();
+        modified = home.alloc<int>(n);      isModified = home.alloc<bool>(n);
+        for (int i = 0; i < n; i++)
+            isModified[i] = p.isModified[i];
+        for (int i = 0; i < p.nModified; i++)
+            modified[i] = p.modified[i];
+        nModified = p.nModified;            nUnassigned = p.nUnassigned;
+    }
+
+    Propagator* copy(Space& home) override {
+        return new (home) VoiceLeadingRules(home, *this);
+    }
+
+    PropCost cost(const Space&, const ModEventDelta&) const override {
+        return PropCost::linear(PropCost::LO, nModified);
+    }
+
+    void reschedule(Space& home) override {
+        IntView::schedule(home, *this, ME_INT_DOM);
+    }
+
+    /**
+     * Records the position of the modified variable. The propagator is scheduled to filter the windows around it.
+     */
+    ExecStatus advise(Space&, Advisor& a, const Delta& d) override {
+        const auto& advisor = static_cast<ChordAdvisor&>(a);
+        if (IntView::modevent(d) == ME_INT_VAL)
+            nUnassigned--;
+        mark(advisor.position);
+        return ES_NOFIX;
+    }
+
+    /**
+     * Filters the windows around the modified positions until no position is left on the stack. Positions modified
+     * by the filtering itself are pushed again, so the propagator is at fixpoint when it returns.
+     */
+    ExecStatus propagate(Space& home, const ModEventDelta&) override {
+        const int n = chords.size();
+        while (nModified > 0) {
+            const int i = modified[--nModified];
+            isModified[i] = false;
+            GECODE_ES_CHECK(single_chord(home, i));
+            if (i > 0)
+                GECODE_ES_CHECK(successive_chords(home, i - 1));
+            if (i + 1 < n)
+                GECODE_ES_CHECK(successive_chords(home, i));
+        }
+        if (nUnassigned <= 0)
+            return home.ES_SUBSUMED(*this);
+        return ES_FIX;
+    }
+
+    size_t dispose(Space& home) override {
+        for (Advisors<ChordAdvisor> as(council); as(); ++as) {
+            ChordAdvisor& a = as.advisor();
+            if (a.array == 0)           chords[a.position]      .cancel(home, a);
+            else if (a.array == 1)      states[a.position]      .cancel(home, a);
+            else                        qualities[a.position]   .cancel(home, a);
+        }
+        council.dispose(home);
+        (void) Propagator::dispose(home);
+        return sizeof(*this);
+    }
+
+    /**
+     * Posts the propagator
+     * @param home the space
+     * @param c the degrees of the chords
+     * @param s the states of the chords
+     * @param q the qualities of the chords
+     * @return the status of the posting
+     */
+    static ExecStatus post(Home home, ViewArray<IntView>& c, ViewArray<IntView>& s, ViewArray<IntView>& q) {
+        if (c.size() == 0)
+            return ES_OK;
+        (void) new (home) VoiceLeadingRules(home, c, s, q);
+        return ES_OK;
+    }
+};
+
+/**
+ * Posts a single propagator enforcing the rules of tritone_resolutions, seventh_chords_preparation and
+ * diminished_seventh_dominant_chords on the whole progression. The bass and the notes of the chords are read from
+ * bassBasedOnDegreeAndState instead of the auxiliary variable arrays, and only the windows around the chords whose
+ * variables changed are checked again.
+ * @param home the problem space
+ * @param chords the array of chord degrees
+ * @param states the array of chord states
+ * @param qualities the array of chord qualities
+ */
+void voice_leading_rules(Home home, const IntVarArray &chords, const IntVarArray &states, const IntVarArray &qualities) {
+    GECODE_POST;
+    ViewArray<IntView> c(home, IntVarArgs(chords));
+    ViewArray<IntView> s(home, IntVarArgs(states));
+    ViewArray<IntView> q(home, IntVarArgs(qualities));
+    GECODE_ES_FAIL(VoiceLeadingRules::post(home, c, s, q));
+}
+
+/**
+ * Whether two successive chords respect the rules enforced by voice_leading_rules (tritone resolutions and preparation
+ * of the seventh). See src/VoiceLeadingPropagator.cpp.
+ * @param degree the degree of the first chord
+ * @param state the state of the first chord
+ * @param quality the quality of the first chord
+ * @param nextDegree the degree of the second chord
+ * @param nextState the state of the second chord
+ * @param nextQuality the quality of the second chord
+ * @return true if the succession is legal
+ */
+bool is_legal_voice_leading(const int degree, const int state, const int quality, const int nextDegree,
+                            const int nextState, const int nextQuality) {
+    const int required = required_next_bass(is_dominant(degree, quality), state, bass_of(degree, state));
+    if (required == -2 || (required >= 0 && bass_of(nextDegree, nextState) != required))
+        return false;
+    return !needs_preparation(nextDegree, nextQuality) || is_prepared(degree, nextDegree);
+}
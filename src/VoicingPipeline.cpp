@@ -0,0 +1,205 @@
+//
+// Created on 16/10/2026.
+//
+
+#include "../headers/VoicingPipeline.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+/**
+ * A bounded queue of progressions between the producer and the voicing workers. Once closed, push fails and pop only
+ * returns the progressions that are already in the queue.
+ */
+class CandidateQueue {
+private:
+    std::mutex                      mutex;
+    std::condition_variable         notFull;
+    std::condition_variable         notEmpty;
+    std::deque<HarmoniserSolution>  candidates;
+    const size_t                    capacity;
+    bool                            closed = false;
+
+public:
+    explicit CandidateQueue(const size_t capacity) : capacity(std::max<size_t>(1, capacity)) {}
+
+    bool push(const HarmoniserSolution& candidate) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this]() { return closed || candidates.size() < capacity; });
+        if (closed)
+            return false;
+        candidates.push_back(candidate);
+        notEmpty.notify_one();
+        return true;
+    }
+
+    bool pop(HarmoniserSolution& candidate) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this]() { return closed || !candidates.empty(); });
+        if (candidates.empty())
+            return false;
+        candidate = std::move(candidates.front());
+        candidates.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    /**
+     * Closes the queue
+     * @param drop if true, the progressions waiting in the queue are removed
+     */
+    void close(const bool drop) {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        if (drop)
+            candidates.clear();
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+};
+
+/**
+ * Stops a voicing when its time limit is reached or when the pipeline has enough voiced pieces.
+ */
+class VoicingStop : public Search::Stop {
+private:
+    const std::chrono::steady_clock::time_point start;  /// the time at which the voicing started
+    const unsigned int timeLimit;                       /// the time limit in milliseconds, 0 for none
+    const std::atomic<bool>& done;                      /// whether the pipeline is over
+
+public:
+    VoicingStop(const unsigned int timeLimit, const std::atomic<bool>& done) :
+        start(std::chrono::steady_clock::now()), timeLimit(timeLimit), done(done) {}
+
+    bool stop(const Search::Statistics&, const Search::Options&) override {
+        if (done.load(std::memory_order_relaxed))
+            return true;
+        return timeLimit > 0 && std::chrono::steady_clock::now() - start > std::chrono::milliseconds(timeLimit);
+    }
+};
+
+/**
+ * Creates the parameters of the four voice texture problem for a solution of the progression problem: the degrees,
+ * states and qualities of each progression, and the modulations of the piece.
+ * @param params the parameters of the piece
+ * @param solution a solution of the piece
+ * @return the parameters for solve_diatony, along with the parameters of the sections and modulations they refer to
+ */
+std::unique_ptr<DiatonyParameters> to_diatony_parameters(const TonalPieceParameters& params,
+                                                         const HarmoniserSolution& solution) {
+    auto diatony = std::make_unique<DiatonyParameters>();
+    vector<TonalProgressionParameters*> sectionParams;
+    vector<ModulationParameters*> modulationParams;
+    sectionParams.reserve(params.get_nProgressions());
+    modulationParams.reserve(params.get_nProgressions() - 1);
+
+    for (int i = 0; i < params.get_nProgressions(); i++) {
+        const int start = params.get_progressionStart(i);
+        const int duration = params.get_progressionDuration(i);
+        const vector<int> states(solution.states.begin() + start, solution.states.begin() + start + duration);
+        const vector<int> qualities(solution.qualities.begin() + start, solution.qualities.begin() + start + duration);
+        diatony->sections.emplace_back(new TonalProgressionParameters(i, duration, start, start + duration - 1,
+                                                                      params.get_tonality(i), solution.degrees[i],
+                                                                      qualities, states));
+        sectionParams.push_back(diatony->sections.back().get());
+    }
+    for (int i = 0; i < params.get_nProgressions() - 1; i++) {
+        diatony->modulations.emplace_back(new ModulationParameters(params.get_modulationType(i),
+                                                                   params.get_modulationStart(i),
+                                                                   params.get_modulationEnd(i), sectionParams[i],
+                                                                   sectionParams[i + 1]));
+        modulationParams.push_back(diatony->modulations.back().get());
+    }
+    diatony->piece = std::make_unique<FourVoiceTextureParameters>(params.get_size(), params.get_nProgressions(),
+                                                                  sectionParams, modulationParams);
+    return diatony;
+}
+
+/**
+ * Generates progressions and voices them with Diatony concurrently. The calling thread enumerates the progressions of the
+ * piece (see enumerate_harmoniser) into a bounded queue, and blocks when the queue is full. The voicing workers take
+ * the progressions from the queue and solve their four voice texture, so that a progression that cannot be voiced only
+ * costs its own voicing. Once enough pieces are voiced, the enumeration and the running voicings are stopped.
+ * A voicing that throws is skipped like a progression that cannot be voiced. If no piece could be voiced, the first
+ * exception thrown by a voicing is rethrown once the workers are done.
+ * @param params the parameters of the piece
+ * @param pipeline the options of the pipeline
+ * @param options the search options of the progressions, the restart, LNS and portfolio modes are not supported
+ * @return the voiced pieces, at most pipeline.wanted of them
+ */
+vector<VoicedPiece> solve_pipeline(TonalPieceParameters* params, const PipelineOptions& pipeline,
+                                   const HarmoniserOptions& options) {
+    if (pipeline.wanted == 0)
+        return {};
+    unsigned int workers = pipeline.voicingWorkers;
+    if (workers == 0)
+        workers = std::max(2U, std::thread::hardware_concurrency()) - 1;
+
+    CandidateQueue queue(pipeline.queueCapacity);
+    std::atomic<bool> done(false);
+    std::mutex resultsMutex;
+    vector<VoicedPiece> results;
+    std::exception_ptr error;
+
+    const auto voice = [&]() {
+        HarmoniserSolution candidate;
+        while (queue.pop(candidate)) {
+            auto diatonyParams = to_diatony_parameters(*params, candidate);
+            const int nChords = diatonyParams->piece->get_totalNumberOfChords();
+            VoicingStop stop(pipeline.voicingTimeLimit, done);
+            Search::Options opts;
+            opts.threads = 1;
+            opts.stop = &stop;
+            opts.cutoff = Search::Cutoff::merge(Search::Cutoff::linear(2 * nChords),
+                                                Search::Cutoff::geometric(4 * nChords * 4 * nChords, 2));
+            opts.nogoods_limit = nChords * 4 * 4;
+
+            std::unique_ptr<FourVoiceTexture> voicing;
+            try {
+                voicing.reset(solve_diatony(diatonyParams->piece.get(), &opts, false));
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(resultsMutex);
+                if (!error)
+                    error = std::current_exception();
+                continue;               /// treated as a progression that cannot be voiced
+            }
+            if (voicing == nullptr)
+                continue;               /// this progression cannot be voiced, try the next one
+            std::lock_guard<std::mutex> lock(resultsMutex);
+            if (results.size() < pipeline.wanted)
+                results.push_back({candidate, std::move(diatonyParams), std::move(voicing)});
+            if (results.size() == pipeline.wanted && !done.exchange(true))
+                queue.close(true);
+        }
+    };
+
+    vector<std::thread> pool;
+    pool.reserve(workers);
+    for (unsigned int i = 0; i < workers; i++)
+        pool.emplace_back(voice);
+
+    /// the sink blocks while the queue is full, and stops the enumeration once the queue is closed
+    const SolutionSink produce = [&queue](const HarmoniserSolution& candidate) { return queue.push(candidate); };
+    try {
+        /// the branching is posted by enumerate_harmoniser with the seed of the options
+        enumerate_harmoniser(new TonalPiece(params, false), produce, pipeline.maxCandidates, options);
+    } catch (...) {
+        done = true;
+        queue.close(true);
+        for (auto& t : pool)
+            t.join();
+        throw;
+    }
+    /// no more progressions, the workers voice the remaining ones and exit
+    queue.close(false);
+    for (auto& t : pool)
+        t.join();
+    if (results.empty() && error)
+        std::rethrow_exception(error);
+    return results;
+}
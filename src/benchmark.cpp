@@ -0,0 +1,174 @@
+//
+// Created on 16/10/2026.
+//
+
+#include "../headers/HarmoniserSolver.hpp"
+#include "../headers/TonalityRegistry.hpp"
+
+#include <chrono>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * Benchmark of the progression model over a grid of pieces. For each size, number of modulations, modulation type, pair
+ * of tonalities and seed, it measures the time to build the model, the time to find a first solution (including the
+ * propagation at the root) and the statistics of the search, and prints one line of CSV per piece on the standard output.
+ * Each piece is solved in its own child process, so that its peak memory is not hidden by the pieces solved before it
+ * and a crash only loses its own line.
+ * usage: ./out/benchmark [maxSize] [timeLimit in ms]
+ */
+
+/// the sizes of the pieces, in number of chords
+const vector<int> sizes = {4, 8, 16, 32, 64, 128, 256, 512, 1024};
+/// the numbers of modulations in a piece
+const vector<int> modulationCounts = {0, 1, 2, 4, 8};
+/// the modulation types, the piece alternates between the two tonalities of its pair
+const vector<int> modulationTypes = {PERFECT_CADENCE_MODULATION, PIVOT_CHORD_MODULATION, ALTERATION_MODULATION,
+                                     CHROMATIC_MODULATION};
+/// the pairs of tonalities as {tonic, mode} of the first and of the second tonality
+const vector<std::array<int, 4>> keyPairs = {
+    {C, MAJOR_MODE, G, MAJOR_MODE},         /// dominant
+    {C, MAJOR_MODE, F, MAJOR_MODE},         /// subdominant
+    {C, MAJOR_MODE, A, MINOR_MODE},         /// relative minor
+    {C, MINOR_MODE, E_FLAT, MAJOR_MODE},    /// relative major
+    {C, MAJOR_MODE, D, MAJOR_MODE},         /// two fifths apart
+};
+/// the seeds of the random value selection
+const vector<unsigned int> seeds = {1, 2, 3};
+/// the minimal number of chords of each tonality
+constexpr int minSectionLength = 4;
+
+/**
+ * Returns the number of chords of a modulation
+ * @param type the type of the modulation
+ * @return the number of chords
+ */
+static int modulation_length(const int type) {
+    return type == PIVOT_CHORD_MODULATION || type == ALTERATION_MODULATION ? 3 : 2;
+}
+
+/**
+ * Returns the columns of the CSV that describe a piece of the grid
+ * @param size the number of chords
+ * @param nModulations the number of modulations
+ * @param type the type of the modulations
+ * @param keys the pair of tonalities
+ * @param seed the seed of the random value selection
+ * @return the columns, followed by a comma
+ */
+static string describe(const int size, const int nModulations, const int type, const std::array<int, 4>& keys,
+                       const unsigned int seed) {
+    std::ostringstream os;
+    os << size << "," << nModulations << "," << (nModulations > 0 ? modulation_type_names[type] : "none") << ","
+       << TonalityRegistry::get(keys[0], keys[1])->get_name() << ","
+       << (nModulations > 0 ? TonalityRegistry::get(keys[2], keys[3])->get_name() : "none") << "," << seed << ",";
+    return os.str();
+}
+
+/**
+ * Builds and solves one piece of the grid, and prints its line of CSV. It runs in the child process of the piece, so
+ * the peak memory of the process is the one of this piece.
+ * @param size the number of chords
+ * @param nModulations the number of modulations
+ * @param type the type of the modulations
+ * @param keys the pair of tonalities
+ * @param seed the seed of the random value selection
+ * @param timeLimit the time limit of the search in milliseconds
+ */
+static void run(const int size, const int nModulations, const int type, const std::array<int, 4>& keys,
+                const unsigned int seed, const unsigned int timeLimit) {
+    Tonality* from = TonalityRegistry::get(keys[0], keys[1]);
+    Tonality* to = TonalityRegistry::get(keys[2], keys[3]);
+
+    /// the tonalities have the same length, each modulation starts on the last chord of a tonality
+    const int sectionLength = size / (nModulations + 1);
+    vector<Tonality*> tonalities;
+    vector<int> types, starts, ends;
+    for (int i = 0; i <= nModulations; i++)
+        tonalities.push_back(i % 2 == 0 ? from : to);
+    for (int i = 0; i < nModulations; i++) {
+        types.push_back(type);
+        starts.push_back((i + 1) * sectionLength - 1);
+        ends.push_back(starts.back() + modulation_length(type) - 1);
+    }
+
+    /// the line is printed at once, so that a crash does not leave half a line
+    std::ostringstream line;
+    line << describe(size, nModulations, type, keys, seed);
+    try {
+        TonalPieceParameters params(size, nModulations + 1, tonalities, types, starts, ends);
+        const auto buildStart = std::chrono::steady_clock::now();
+        auto piece = new TonalPiece(&params, true, seed);
+        const std::chrono::duration<double, std::milli> build = std::chrono::steady_clock::now() - buildStart;
+
+        HarmoniserOptions options;
+        options.timeLimit = timeLimit;
+        SearchReport report;
+        const auto solveStart = std::chrono::steady_clock::now();
+        const auto sol = solve_harmoniser(piece, report, false, options);
+        const std::chrono::duration<double, std::milli> solve = std::chrono::steady_clock::now() - solveStart;
+        const string status = sol != nullptr ? "solved" : report.stopped ? "timeout" : "unsatisfiable";
+        delete sol;
+
+        line << build.count() << "," << solve.count() << "," << report.statistics.node << ","
+             << report.statistics.fail << "," << report.statistics.propagate << "," << report.processPeakRss / 1024
+             << "," << report.clones << "," << status;
+    } catch (const std::exception& e) {
+        line << ",,,,,,,error";
+        std::cerr << size << " chords, " << nModulations << " modulations: " << e.what() << std::endl;
+    }
+    std::cout << line.str() << std::endl;
+}
+
+/**
+ * Runs one piece of the grid in a child process (see run), and prints an error line if the child does not exit normally
+ * @param size the number of chords
+ * @param nModulations the number of modulations
+ * @param type the type of the modulations
+ * @param keys the pair of tonalities
+ * @param seed the seed of the random value selection
+ * @param timeLimit the time limit of the search in milliseconds
+ */
+static void run_in_child(const int size, const int nModulations, const int type, const std::array<int, 4>& keys,
+                         const unsigned int seed, const unsigned int timeLimit) {
+    std::cout.flush();      /// the child would print the buffered output again
+    const pid_t pid = fork();
+    if (pid == 0) {
+        run(size, nModulations, type, keys, seed, timeLimit);
+        std::cout.flush();
+        _exit(0);
+    }
+    int status = 0;
+    if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cout << describe(size, nModulations, type, keys, seed) << ",,,,,,,error" << std::endl;
+        std::cerr << size << " chords, " << nModulations << " modulations: the child process failed" << std::endl;
+    }
+}
+
+int main(int argc, char **argv) {
+    const int maxSize = argc > 1 ? std::stoi(argv[1]) : sizes.back();
+    const unsigned int timeLimit = argc > 2 ? static_cast<unsigned int>(std::stoul(argv[2])) : 10000;
+
+    std::cout << "size,modulations,modulation_type,first_tonality,second_tonality,seed,build_ms,first_solution_ms,"
+                 "nodes,fails,propagations,peak_memory_kb,clones,status" << std::endl;
+    for (const int size : sizes) {
+        if (size > maxSize)
+            break;
+        for (const int nModulations : modulationCounts) {
+            if (size / (nModulations + 1) < minSectionLength)
+                continue;
+            for (size_t t = 0; t < modulationTypes.size(); t++) {
+                for (size_t k = 0; k < keyPairs.size(); k++) {
+                    /// without modulation, only the first tonality matters
+                    if (nModulations == 0 && (t > 0 || (k > 0 && keyPairs[k][0] == keyPairs[0][0] &&
+                                                         keyPairs[k][1] == keyPairs[0][1])))
+                        continue;
+                    for (const unsigned int seed : seeds)
+                        run_in_child(size, nModulations, modulationTypes[t], keyPairs[k], seed, timeLimit);
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,170 @@
+//
+// Created on 16/10/2026.
+//
+
+#include "../headers/BitsetSolver.hpp"
+#include "../headers/SolutionCounter.hpp"
+
+#include <algorithm>
+#include <array>
+
+/**
+ * Cross-check of the models and solvers of the progressions. The solutions of small pieces are enumerated with each
+ * combination of the ModelOptions, on pieces with a single tonality and on pieces with each type of modulation, and
+ * must be the same as the solutions of the default model. For the pieces with a single tonality, the solutions of the
+ * BitsetSolver and of the SolutionCounter (by index) must also be the same. It prints one line per piece and returns 1
+ * if any piece differs.
+ * usage: ./out/check [maxSize]
+ */
+
+/// the tonalities of the pieces with a single tonality as {tonic, mode}
+const vector<std::array<int, 2>> keys = {{C, MAJOR_MODE}, {A, MINOR_MODE}, {E_FLAT, MAJOR_MODE}, {F_SHARP, MINOR_MODE}};
+/// the modulation types, each piece modulates from C major to G major
+const vector<int> modulationTypes = {PERFECT_CADENCE_MODULATION, PIVOT_CHORD_MODULATION, ALTERATION_MODULATION,
+                                     CHROMATIC_MODULATION};
+/// the number of chords of each tonality in the pieces with a modulation
+constexpr int sectionLength = 3;
+/// the number of combinations of the model options (see model_options)
+constexpr int nModelOptions = 16;
+
+/**
+ * Returns a combination of the model options
+ * @param k the index of the combination, each bit sets one of the options
+ * @return the model options
+ */
+static ModelOptions model_options(const int k) {
+    ModelOptions options;
+    options.tableModel              = (k & 1) != 0;
+    options.transitionAutomaton     = (k & 2) != 0;
+    options.voiceLeadingPropagator  = (k & 4) != 0;
+    options.leanSpace               = (k & 8) != 0;
+    return options;
+}
+
+/**
+ * Returns a solution on a single line, so that the solutions of the different models and solvers can be compared
+ * @param degrees the degrees of each progression
+ * @param states the state of each chord
+ * @param qualities the quality of each chord
+ * @return the degrees of each progression, the states and the qualities
+ */
+static string solution_string(const vector<vector<int>>& degrees, const vector<int>& states,
+                              const vector<int>& qualities) {
+    string txt;
+    for (const auto& progression : degrees) {
+        for (const int degree : progression)
+            txt += to_string(degree) + ",";
+        txt += ";";
+    }
+    txt += "|";
+    for (const int state : states)
+        txt += to_string(state) + ",";
+    txt += "|";
+    for (const int quality : qualities)
+        txt += to_string(quality) + ",";
+    return txt;
+}
+
+/**
+ * Enumerates the solutions of a piece with the model of its options
+ * @param params the parameters of the piece
+ * @return the solutions (see solution_string), sorted
+ */
+static vector<string> model_solutions(TonalPieceParameters& params) {
+    vector<string> solutions;
+    const auto root = new TonalPiece(&params);
+    DFS<TonalPiece> engine(root);
+    delete root;
+    while (TonalPiece* sol = engine.next()) {
+        vector<vector<int>> degrees;
+        for (int k = 0; k < params.get_nProgressions(); k++)
+            degrees.push_back(intVarArray_to_int_vector(sol->getChordProgression(k)->getChords()));
+        solutions.push_back(solution_string(degrees, intVarArray_to_int_vector(sol->getStates()),
+                                            intVarArray_to_int_vector(sol->getQualities())));
+        delete sol;
+    }
+    std::sort(solutions.begin(), solutions.end());
+    return solutions;
+}
+
+/**
+ * Enumerates the solutions of a piece with each combination of the model options, and compares them with the
+ * solutions of the default model
+ * @param params the parameters of the piece, its model options are reset to the default ones
+ * @param name the name of the piece
+ * @return true if every model finds the same solutions
+ */
+static bool check_models(TonalPieceParameters& params, const string& name) {
+    params.set_modelOptions(model_options(0));
+    const vector<string> reference = model_solutions(params);
+    bool same = true;
+    std::cout << name << ": " << reference.size() << " solutions";
+    for (int k = 1; k < nModelOptions; k++) {
+        params.set_modelOptions(model_options(k));
+        if (model_solutions(params) != reference) {
+            std::cout << ", model options " << k << " DIFFERENT";
+            same = false;
+        }
+    }
+    params.set_modelOptions(model_options(0));
+    std::cout << std::endl;
+    return same;
+}
+
+/**
+ * Enumerates the solutions of a piece with a single tonality with the BitsetSolver and with the SolutionCounter, and
+ * compares them with the solutions of the default model
+ * @param params the parameters of the piece
+ * @param name the name of the piece
+ * @return true if the solvers find the same solutions as the model
+ */
+static bool check_solvers(TonalPieceParameters& params, const string& name) {
+    const vector<string> reference = model_solutions(params);
+
+    vector<string> bitset;
+    BitsetSolver(&params).enumerate([&bitset](const HarmoniserSolution& sol) {
+        bitset.push_back(solution_string(sol.degrees, sol.states, sol.qualities));
+        return true;
+    });
+    std::sort(bitset.begin(), bitset.end());
+
+    const SolutionCounter counter(&params);
+    vector<string> counted;
+    for (BigUInt k = 0; k < counter.count(); k += 1) {
+        const HarmoniserSolution sol = counter.solution(k);
+        counted.push_back(solution_string(sol.degrees, sol.states, sol.qualities));
+    }
+    std::sort(counted.begin(), counted.end());
+
+    const bool same = bitset == reference && counted == reference;
+    std::cout << name << ": " << bitset.size() << " solutions (bitset), " << counter.count().to_string()
+              << " (counter)" << (same ? "" : " DIFFERENT") << std::endl;
+    return same;
+}
+
+int main(int argc, char **argv) {
+    const int maxSize = argc > 1 ? std::stoi(argv[1]) : 4;
+
+    bool same = true;
+    for (const auto& key : keys) {
+        Tonality* tonality = TonalityRegistry::get(key[0], key[1]);
+        for (int size = 1; size <= maxSize; size++) {
+            TonalPieceParameters params(size, 1, {tonality}, {}, {}, {});
+            const string name = tonality->get_name() + ", " + to_string(size) + " chords";
+            same = check_models(params, name) && same;
+            same = check_solvers(params, name) && same;
+        }
+    }
+
+    /// the modulation starts on the last chord of the first tonality
+    Tonality* from = TonalityRegistry::get(C, MAJOR_MODE);
+    Tonality* to = TonalityRegistry::get(G, MAJOR_MODE);
+    for (const int type : modulationTypes) {
+        const int length = type == PIVOT_CHORD_MODULATION || type == ALTERATION_MODULATION ? 3 : 2;
+        TonalPieceParameters params(2 * sectionLength, 2, {from, to}, {type}, {sectionLength - 1},
+                                    {sectionLength + length - 2});
+        same = check_models(params, from->get_name() + " to " + to->get_name() + ", " + modulation_type_names[type]) &&
+               same;
+    }
+    return same ? 0 : 1;
+}
@@ -6,6 +6,8 @@
 #include "../Diatony/c++/headers/aux/MidiFileGeneration.hpp"
 
 #include "../headers/HarmoniserSolver.hpp"
+#include "../headers/TonalityRegistry.hpp"
+#include "../headers/VoicingPipeline.hpp"
 
 // todo ajouter les 64 de passage (cst en plus du coup)
 // todo rename secondary dominant modulation to chromatic modulation
@@ -14,9 +16,9 @@ int main(int argc, char **argv) {
 
     // parameters of the layer 2 problem
     int size = 4;
-    Tonality* Cminor = new MinorTonality(C);    Tonality* Ebmajor = new MajorTonality(E_FLAT);
-    Tonality* Gmajor = new MajorTonality(G);    Tonality* Bbmajor = new MajorTonality(B_FLAT);
-    Tonality* Dmajor = new MajorTonality(D);    Tonality* Cmajor = new MajorTonality(C);
+    Tonality* Cminor = TonalityRegistry::get(C, MINOR_MODE);    Tonality* Ebmajor = TonalityRegistry::get(E_FLAT, MAJOR_MODE);
+    Tonality* Gmajor = TonalityRegistry::get(G, MAJOR_MODE);    Tonality* Bbmajor = TonalityRegistry::get(B_FLAT, MAJOR_MODE);
+    Tonality* Dmajor = TonalityRegistry::get(D, MAJOR_MODE);    Tonality* Cmajor = TonalityRegistry::get(C, MAJOR_MODE);
     vector<Tonality*> tonalities = {Cmajor, Dmajor};
     vector<int> modulationTypes = {CHROMATIC_MODULATION};
     vector<int> modulationStarts = {1};
@@ -24,6 +26,18 @@ int main(int argc, char **argv) {
 
     auto params = TonalPieceParameters(size, static_cast<int>(tonalities.size()), tonalities,
                                        modulationTypes, modulationStarts, modulationEnds);
+    // Pipeline mode: the progressions are voiced while the next ones are generated
+    if (argc > 2 && string(argv[2]) == "pipeline") {
+        const auto voiced = solve_pipeline(&params);
+        for (const auto& piece : voiced) {
+            std::cout << "Voiced progression: " << piece.progression.toString() << std::endl;
+            writeSolToMIDIFile(piece.voicing->getParameters()->get_totalNumberOfChords(), "out/MidiFiles/sol",
+                               piece.voicing.get());
+            cout << "MIDI file(s) created" << endl;
+        }
+        return 0;
+    }
+
     // Create an instance of the layer 2 problem (progressions and modulations)
     auto tonalPiece = new TonalPiece(&params);
 